@@ -0,0 +1,369 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory_resource>
+#include "Building.h"
+#include "DispatchRules.h"
+#include "JourneyLog.h"
+#include "Traffic.h"
+
+constexpr int FIXED_QUEUE_SIZE = 32; // Waiting passengers per floor and direction kept in place in BasicElevatorEngine
+
+// ElevatorEngine specialised at compile time for a fixed number of floors, cars and
+// capacity. All state lives in std::array and std::bitset members and the call/stop
+// lookups are bit operations on bitsets. Passengers are stored as small value records in
+// fixed-size queues and in a fixed list per car. A floor queue keeps FIXED_QUEUE_SIZE
+// passengers per direction in place; only when more are waiting does it create an
+// overflow deque, on the building's memory resource. Nothing is allocated while the
+// building keeps up with its traffic. For the same configuration and seed the results
+// match ElevatorEngine.
+template<int Floors, int Cars, int Capacity = MAX_CAPACITY>
+class BasicElevatorEngine final : public BuildingSimulation
+{
+	static_assert(Floors >= 2, "A building needs at least two floors");
+	static_assert(Cars >= 1, "A building needs at least one car");
+	static_assert(Capacity >= 1 && Capacity <= 255, "Capacity must fit in a byte");
+
+public:
+	BasicElevatorEngine(const buildingConfig& config_, std::pmr::memory_resource* memory_)
+		: cfg(config_), allocator(memory_), traffic(config_)
+	{
+		cfg.floors = Floors;
+		cfg.cars = Cars;
+		cfg.capacity = Capacity;
+	}
+
+	~BasicElevatorEngine() override
+	{
+		for (auto& floor : queues)
+		{
+			for (waitingQueue& queue : floor)
+			{
+				if (queue.overflow)
+				{
+					allocator.delete_object(queue.overflow);
+				}
+			}
+		}
+	}
+
+	BasicElevatorEngine(const BasicElevatorEngine&) = delete;
+	BasicElevatorEngine& operator=(const BasicElevatorEngine&) = delete;
+
+	void advanceTo(double endTime) override
+	{
+		while (true)
+		{
+			int next = 0;
+			for (int i = 1; i < Cars; i++)
+			{
+				if (cars[i].readyAt < cars[next].readyAt)
+				{
+					next = i;
+				}
+			}
+			double carTime = cars[next].readyAt;
+			if (traffic.nextArrival() <= carTime)
+			{
+				if (traffic.nextArrival() > endTime)
+				{
+					break;
+				}
+				now = traffic.nextArrival();
+				spawnPassenger();
+			}
+			else
+			{
+				if (carTime > endTime)
+				{
+					break;
+				}
+				now = carTime;
+				serveCar(cars[next]);
+			}
+		}
+		now = endTime;
+	}
+
+	double time() const override { return now; }
+	const buildingMetrics& metrics() const override { return stats; }
+	const buildingConfig& config() const override { return cfg; }
+
+	void view(buildingView& out) const override
+	{
+		out.time = now;
+		out.cars.resize(Cars);
+		for (int i = 0; i < Cars; i++)
+		{
+			const car& c = cars[i];
+			carView& v = out.cars[i];
+			v.floor = c.floor;
+			v.goingUp = c.goingUp;
+			v.dwelling = c.dwelling;
+			v.riders.clear();
+			for (int r = 0; r < c.load; r++)
+			{
+				v.riders.push_back(c.riders[r].destination);
+			}
+		}
+		out.waiting.resize(Floors);
+		for (int f = 0; f < Floors; f++)
+		{
+			// Merge both directions by passenger id, i.e. in arrival order
+			const waitingQueue& down = queues[f][0];
+			const waitingQueue& up = queues[f][1];
+			auto& list = out.waiting[f];
+			list.clear();
+			int u = 0;
+			int d = 0;
+			while (u < up.size() || d < down.size())
+			{
+				if (d == down.size() || (u < up.size() && up.at(u).passengerId < down.at(d).passengerId))
+				{
+					list.push_back(up.at(u++).destination);
+				}
+				else
+				{
+					list.push_back(down.at(d++).destination);
+				}
+			}
+		}
+	}
+
+	void addUnserved(buildingMetrics& metrics) const override
+	{
+		for (const auto& floor : queues)
+		{
+			for (const waitingQueue& queue : floor)
+			{
+				for (int i = 0; i < queue.size(); i++)
+				{
+					metrics.totalWait += now - queue.at(i).arrivalTime;
+					recordWait(metrics, now - queue.at(i).arrivalTime);
+					++metrics.unserved;
+				}
+			}
+		}
+	}
+
+private:
+	using floorSet = std::bitset<Floors>;
+
+	struct waiting
+	{
+		double arrivalTime;
+		uint32_t passengerId;
+		int destination;
+	};
+
+	struct rider
+	{
+		double arrivalTime;
+		double boardTime;
+		uint32_t passengerId;
+		int16_t startFloor;
+		int16_t destination;
+	};
+
+	// FIFO of passengers waiting on one floor for one direction. The oldest
+	// FIXED_QUEUE_SIZE are in the ring, younger ones in overflow, which is created by the
+	// first push into a full ring and kept until the engine is destroyed.
+	struct waitingQueue
+	{
+		using overflowDeque = std::pmr::deque<waiting>;
+
+		std::array<waiting, FIXED_QUEUE_SIZE> items;
+		int head = 0;
+		int count = 0; // Passengers in the ring
+		overflowDeque* overflow = nullptr;
+
+		int size() const { return count + (overflow ? static_cast<int>(overflow->size()) : 0); }
+		const waiting& at(int i) const
+		{
+			return i < count ? items[(head + i) % FIXED_QUEUE_SIZE] : (*overflow)[static_cast<size_t>(i - count)];
+		}
+
+		void push(const waiting& w, std::pmr::polymorphic_allocator<>& allocator)
+		{
+			if (count == FIXED_QUEUE_SIZE)
+			{
+				if (!overflow)
+				{
+					overflow = allocator.new_object<overflowDeque>();
+				}
+				overflow->push_back(w);
+				return;
+			}
+			items[(head + count) % FIXED_QUEUE_SIZE] = w;
+			++count;
+		}
+
+		// Removes the oldest passenger and refills the ring from overflow
+		void pop()
+		{
+			head = (head + 1) % FIXED_QUEUE_SIZE;
+			--count;
+			if (overflow && !overflow->empty())
+			{
+				items[(head + count) % FIXED_QUEUE_SIZE] = overflow->front();
+				overflow->pop_front();
+				++count;
+			}
+		}
+	};
+
+	struct car
+	{
+		int floor = 0;
+		bool goingUp = true;
+		bool dwelling = false; // Stopped with the door open or closing; readyAt is when it is closed
+		doorCycle door;
+		double readyAt = 0.0;
+		double idleSince = -1.0;
+		int load = 0;
+		std::array<rider, Capacity> riders; // the first load entries are in use
+		floorSet stops; // destinations of the passengers in the car
+	};
+
+	buildingConfig cfg;
+	std::pmr::polymorphic_allocator<> allocator;
+	TrafficGenerator traffic;
+	std::array<std::array<waitingQueue, 2>, Floors> queues; // [floor][1 = up, 0 = down]
+	floorSet calls; // floors with at least one waiting passenger
+	std::array<car, Cars> cars;
+	buildingMetrics stats;
+	double now = 0.0;
+	uint32_t nextPassengerId = 0;
+
+	static floorSet above(int floor) { return floor + 1 < Floors ? ~floorSet() << (floor + 1) : floorSet(); }
+	static floorSet below(int floor) { return ~(~floorSet() << floor); }
+
+	void spawnPassenger()
+	{
+		trafficCall call = traffic.pop();
+		uint32_t passengerId = nextPassengerId++;
+		++stats.arrived;
+
+		// A car going the same way standing at the floor takes the passenger straight in
+		bool upward = call.destination > call.startFloor;
+		for (auto& c : cars)
+		{
+			if (c.dwelling && c.floor == call.startFloor && c.goingUp == upward && c.load < Capacity)
+			{
+				c.door.transfer(now, c.load, Capacity);
+				c.riders[c.load++] = { now, now, passengerId, static_cast<int16_t>(call.startFloor), static_cast<int16_t>(call.destination) };
+				c.stops.set(call.destination);
+				c.readyAt = std::max(c.readyAt, c.door.closedAt());
+				recordWait(stats, 0.0);
+				++stats.boarded;
+				return;
+			}
+		}
+
+		queues[call.startFloor][call.destination > call.startFloor ? 1 : 0].push({ now, passengerId, call.destination }, allocator);
+		calls.set(call.startFloor);
+	}
+
+	void serveCar(car& c)
+	{
+		if (!c.dwelling)
+		{
+			unloadAndLoad(c);
+			if (c.door.active)
+			{
+				// Stay until the door is closed; late passengers can still board
+				c.dwelling = true;
+				c.readyAt = c.door.closedAt();
+				return;
+			}
+		}
+		c.dwelling = false;
+		c.door = {};
+
+		// 3. Decide direction and 4. move the car
+		bool loadAllowsCalls = acceptsCalls(c.load, Capacity, cfg.dispatch);
+		bool hasAbove = (loadAllowsCalls && (calls & above(c.floor)).any()) || (c.stops & above(c.floor)).any();
+		bool hasBelow = (loadAllowsCalls && (calls & below(c.floor)).any()) || (c.stops & below(c.floor)).any();
+		bool idle = false;
+		int step = decideStep(c.goingUp, hasAbove, hasBelow, c.load == 0, idle);
+		if (idle)
+		{
+			if (c.idleSince < 0.0)
+			{
+				c.idleSince = now;
+			}
+			step = idleStep(c.goingUp, c.floor, now - c.idleSince, cfg.dispatch);
+		}
+		else
+		{
+			c.idleSince = -1.0;
+		}
+		c.floor += step;
+		clampDirection(c.goingUp, c.floor, Floors);
+		if (step != 0)
+		{
+			c.readyAt = now + FLOOR_TRAVEL_TIME;
+			stats.energy += ENERGY_PER_FLOOR + ENERGY_PER_PASSENGER_FLOOR * static_cast<double>(c.load);
+			++stats.floorsTravelled;
+		}
+		else
+		{
+			c.readyAt = now + IDLE_POLL_TIME;
+		}
+	}
+
+	void unloadAndLoad(car& c)
+	{
+		// 1. Unload passengers whose destination is the current floor
+		if (c.stops.test(c.floor))
+		{
+			int leaving = 0;
+			int kept = 0;
+			for (int i = 0; i < c.load; i++)
+			{
+				const rider& r = c.riders[i];
+				if (r.destination == c.floor)
+				{
+					c.door.transfer(now, c.load - leaving, Capacity);
+					if (cfg.journeyLog)
+					{
+						cfg.journeyLog->append({ r.passengerId, cfg.buildingId, static_cast<int16_t>(&c - cars.data()),
+							r.startFloor, r.destination, r.arrivalTime, r.boardTime, now });
+					}
+					++leaving;
+				}
+				else
+				{
+					c.riders[kept++] = r;
+				}
+			}
+			c.load = kept;
+			c.stops.reset(c.floor);
+			stats.delivered += leaving;
+		}
+
+		// 2. Load passengers going in the current direction
+		waitingQueue& queue = queues[c.floor][c.goingUp ? 1 : 0];
+		int boarded = 0;
+		while (queue.count > 0 && c.load < Capacity)
+		{
+			const waiting& w = queue.items[queue.head];
+			c.door.transfer(now, c.load, Capacity);
+			stats.totalWait += now - w.arrivalTime;
+			recordWait(stats, now - w.arrivalTime);
+			c.riders[c.load++] = { w.arrivalTime, now, w.passengerId, static_cast<int16_t>(c.floor), static_cast<int16_t>(w.destination) };
+			c.stops.set(w.destination);
+			queue.pop();
+			++boarded;
+		}
+		stats.boarded += boarded;
+		if (queues[c.floor][0].count == 0 && queues[c.floor][1].count == 0)
+		{
+			calls.reset(c.floor);
+		}
+	}
+};
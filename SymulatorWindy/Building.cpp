@@ -0,0 +1,66 @@
+#include "Building.h"
+#include <algorithm>
+#include <array>
+#include <utility>
+#include "BasicElevatorEngine.h"
+#include "ElevatorEngine.h"
+
+namespace
+{
+	// Configurations that get a compile-time specialised engine
+	constexpr int MIN_FIXED_FLOORS = 5;
+	constexpr int MAX_FIXED_FLOORS = 20;
+	constexpr int MAX_FIXED_CARS = 4;
+
+	using buildingFactory = BuildingPtr(*)(const buildingConfig&, std::pmr::memory_resource*);
+
+	template<int Floors, int Cars>
+	BuildingPtr makeFixedBuilding(const buildingConfig& config, std::pmr::memory_resource* memory)
+	{
+		return allocateBuilding<BasicElevatorEngine<Floors, Cars>>(memory, config, memory);
+	}
+
+	template<int Cars, size_t... FloorOffsets>
+	constexpr std::array<buildingFactory, sizeof...(FloorOffsets)> fixedFloorRow(std::index_sequence<FloorOffsets...>)
+	{
+		return { &makeFixedBuilding<MIN_FIXED_FLOORS + static_cast<int>(FloorOffsets), Cars>... };
+	}
+
+	template<size_t... CarOffsets>
+	constexpr auto fixedTable(std::index_sequence<CarOffsets...>)
+	{
+		return std::array{ fixedFloorRow<static_cast<int>(CarOffsets) + 1>(std::make_index_sequence<MAX_FIXED_FLOORS - MIN_FIXED_FLOORS + 1>())... };
+	}
+
+	// FIXED_BUILDINGS[cars - 1][floors - MIN_FIXED_FLOORS]
+	constexpr auto FIXED_BUILDINGS = fixedTable(std::make_index_sequence<MAX_FIXED_CARS>());
+}
+
+carShaft shaftOf(const buildingConfig& config, int car)
+{
+	int decks = std::clamp(config.decks, 1, MAX_DECKS);
+	int perShaft = std::clamp(config.carsPerShaft, 1, MAX_CARS_PER_SHAFT);
+	int first = car - car % perShaft;
+	int inShaft = std::min(perShaft, config.cars - first);
+	int index = car - first;
+	int spare = (inShaft - 1) * decks; // Pit and overrun needed by the other car
+	carShaft shaft;
+	shaft.minFloor = -(decks - 1) - spare + index * decks;
+	shaft.maxFloor = config.floors - 1 + spare - (inShaft - 1 - index) * decks;
+	shaft.startFloor = index * decks;
+	shaft.sibling = inShaft > 1 ? (index == 0 ? car + 1 : car - 1) : -1;
+	shaft.upper = inShaft > 1 && index == 1;
+	return shaft;
+}
+
+BuildingPtr makeBuilding(const buildingConfig& config, std::pmr::memory_resource* memory, bool forceDynamic)
+{
+	if (!forceDynamic && !config.controller && config.capacity == MAX_CAPACITY && !config.learnDemand
+		&& config.decks == 1 && config.carsPerShaft == 1
+		&& config.floors >= MIN_FIXED_FLOORS && config.floors <= MAX_FIXED_FLOORS
+		&& config.cars >= 1 && config.cars <= MAX_FIXED_CARS)
+	{
+		return FIXED_BUILDINGS[config.cars - 1][config.floors - MIN_FIXED_FLOORS](config, memory);
+	}
+	return allocateBuilding<ElevatorEngine>(memory, config, memory);
+}
@@ -0,0 +1,192 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <vector>
+#include "DispatchController.h"
+#include "Dwell.h"
+#include "Simulation.h"
+
+class JourneyLog;
+
+// Interface shared by all headless building engines, plus their configuration and results.
+
+constexpr double FLOOR_TRAVEL_TIME = 2.0; // Seconds needed to move one floor
+constexpr double IDLE_POLL_TIME = 1.0; // Seconds between checks of an idle car for new calls
+constexpr double ENERGY_PER_FLOOR = 0.01; // kWh used to move an empty car one floor
+constexpr double ENERGY_PER_PASSENGER_FLOOR = 0.0015; // Additional kWh per passenger per floor
+constexpr int MAX_DECKS = 2; // Decks of a multi-deck car
+constexpr int MAX_CARS_PER_SHAFT = 2; // Independent cars sharing one shaft
+constexpr double WAIT_BIN_WIDTH = 0.5; // Seconds per bin of the wait histogram
+constexpr int WAIT_BINS = 2048; // Bins of the wait histogram; the last one collects all longer waits
+
+enum class trafficPattern
+{
+	uniform, // Constant arrival rate all day
+	officeDay, // Morning up-peak, lunch trips to a canteen floor, evening down-peak, quiet night
+};
+
+struct buildingConfig
+{
+	int floors = FLOOR_COUNT;
+	int cars = 1;
+	int capacity = MAX_CAPACITY; // Passengers per deck
+	int decks = 1; // Decks per car, serving adjacent floors at the same stop
+	int carsPerShaft = 1; // Cars sharing one shaft; consecutive cars share a shaft
+	double arrivalsPerHour = 300.0; // Average number of new passengers per hour
+	double lobbyShare = 0.5; // Fraction of passengers starting on the ground floor
+	trafficPattern pattern = trafficPattern::uniform;
+	bool learnDemand = false; // Learn a DemandModel and park idle cars where calls are expected
+	unsigned seed = 1;
+	dispatchParams dispatch;
+	unsigned buildingId = 0; // Identifies the building in the journey log
+	JourneyLog* journeyLog = nullptr; // Receives a record for every delivered passenger, if set
+	DispatchController* controller = nullptr; // Decides the moves of departing cars instead of the built-in rule, if set
+	double controllerTick = 0.0; // Seconds between controller decisions; 0 decides as soon as a car is ready
+};
+
+struct buildingMetrics
+{
+	size_t arrived = 0;
+	size_t boarded = 0;
+	size_t delivered = 0;
+	size_t unserved = 0; // Passengers still on the floors, added by BuildingSimulation::addUnserved
+	double totalWait = 0.0; // Seconds waited on the floors by all boarded (and added unserved) passengers
+	double energy = 0.0; // kWh
+	long long floorsTravelled = 0;
+	std::array<uint32_t, WAIT_BINS> waitHistogram{}; // Boarded (and added unserved) passengers by wait time
+};
+
+inline void recordWait(buildingMetrics& metrics, double wait)
+{
+	int bin = static_cast<int>(wait / WAIT_BIN_WIDTH);
+	++metrics.waitHistogram[bin < WAIT_BINS ? bin : WAIT_BINS - 1];
+}
+
+// Wait time below which the given fraction of passengers boarded, interpolated within
+// a histogram bin. Infinite if it falls into the last bin, which only tells that the
+// wait was longer than WAIT_BINS * WAIT_BIN_WIDTH.
+inline double waitPercentile(const buildingMetrics& metrics, double fraction)
+{
+	double total = static_cast<double>(metrics.boarded + metrics.unserved);
+	if (total == 0.0)
+	{
+		return 0.0;
+	}
+	double target = fraction * total;
+	double seen = 0.0;
+	for (int i = 0; i < WAIT_BINS; i++)
+	{
+		double count = metrics.waitHistogram[i];
+		if (count > 0.0 && seen + count >= target)
+		{
+			return i == WAIT_BINS - 1 ? std::numeric_limits<double>::infinity() : (i + (target - seen) / count) * WAIT_BIN_WIDTH;
+		}
+		seen += count;
+	}
+	return std::numeric_limits<double>::infinity();
+}
+
+inline void addMetrics(buildingMetrics& sum, const buildingMetrics& m)
+{
+	sum.arrived += m.arrived;
+	sum.boarded += m.boarded;
+	sum.delivered += m.delivered;
+	sum.unserved += m.unserved;
+	sum.totalWait += m.totalWait;
+	sum.energy += m.energy;
+	sum.floorsTravelled += m.floorsTravelled;
+	for (int i = 0; i < WAIT_BINS; i++)
+	{
+		sum.waitHistogram[i] += m.waitHistogram[i];
+	}
+}
+
+// What a building looks like at one moment, for drawing it
+struct carView
+{
+	int floor = 0; // Position of the lowest deck
+	bool goingUp = true;
+	bool dwelling = false;
+	std::vector<int> riders; // Destinations of the passengers in the car, in boarding order
+};
+
+struct buildingView
+{
+	double time = 0.0;
+	std::vector<carView> cars;
+	std::vector<std::vector<int>> waiting; // [floor] destinations of the waiting passengers, in arrival order
+};
+
+// Where a car runs. Consecutive cars share a shaft and the last shaft may hold fewer cars.
+// A shaft extends below the ground floor and above the top floor (pit and overrun), far
+// enough that every deck of every car in it can reach every floor.
+struct carShaft
+{
+	int minFloor; // Lowest and highest position of the car's lowest deck
+	int maxFloor;
+	int startFloor;
+	int sibling; // Other car in the same shaft, -1 if none
+	bool upper; // This is the upper car of its shaft
+};
+
+carShaft shaftOf(const buildingConfig& config, int car);
+
+class BuildingSimulation
+{
+public:
+	virtual ~BuildingSimulation() = default;
+
+	// Processes all arrivals and car stops up to the given simulation time
+	virtual void advanceTo(double endTime) = 0;
+	virtual double time() const = 0;
+	virtual const buildingMetrics& metrics() const = 0;
+	virtual const buildingConfig& config() const = 0;
+	// Fills out with the current state, reusing its buffers
+	virtual void view(buildingView& out) const = 0;
+	// Adds the passengers still waiting on the floors to metrics as unserved, with the
+	// time they have waited so far in totalWait and waitHistogram. For scoring a run that
+	// ended with passengers left behind.
+	virtual void addUnserved(buildingMetrics& metrics) const = 0;
+
+	// Controller ticking at controllerTick > 0: after advanceTo a tick, the state to send
+	// if a car waits for a command at it, otherwise nullptr. Such a building must be
+	// advanced tick by tick, as Campus does; waiting cars do not move on their own.
+	virtual const controllerState* pendingDecision() { return nullptr; }
+	// Moves the cars waiting at the current tick: by the commands given for this building,
+	// by the built-in rule for cars left out. controllerGone hands every later decision
+	// to the built-in rule.
+	virtual void applyCommands(std::span<const carCommand> commands, bool controllerGone) { (void)commands; (void)controllerGone; }
+};
+
+// Destroys a building allocated by makeBuilding and returns its memory to the pool
+struct buildingDeleter
+{
+	std::pmr::memory_resource* memory;
+	size_t size;
+	size_t alignment;
+
+	void operator()(BuildingSimulation* building) const
+	{
+		building->~BuildingSimulation();
+		memory->deallocate(building, size, alignment);
+	}
+};
+
+using BuildingPtr = std::unique_ptr<BuildingSimulation, buildingDeleter>;
+
+// Picks a compile-time specialised engine for small configurations and the dynamic
+// ElevatorEngine otherwise. forceDynamic or an external controller always selects ElevatorEngine.
+BuildingPtr makeBuilding(const buildingConfig& config, std::pmr::memory_resource* memory, bool forceDynamic = false);
+
+template<typename T, typename... Args>
+BuildingPtr allocateBuilding(std::pmr::memory_resource* memory, Args&&... args)
+{
+	void* storage = memory->allocate(sizeof(T), alignof(T));
+	T* building = new (storage) T(std::forward<Args>(args)...);
+	return BuildingPtr(building, buildingDeleter{ memory, sizeof(T), alignof(T) });
+}
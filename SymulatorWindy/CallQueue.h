@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded multi-producer single-consumer ring buffer. push() may be called from any
+// thread and never blocks or allocates; pop()/drain() must only be called by the single
+// consumer (the simulation thread). Each cell carries a sequence number telling whether
+// it is free for the producer owning that slot or ready for the consumer.
+template<typename T, size_t Capacity>
+class CallQueue
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+	CallQueue()
+	{
+		for (size_t i = 0; i < Capacity; i++)
+		{
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	CallQueue(const CallQueue&) = delete;
+	CallQueue& operator=(const CallQueue&) = delete;
+
+	// Returns false if the queue is full.
+	bool push(const T& value)
+	{
+		size_t pos = tail.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Cell& cell = cells[pos & MASK];
+			size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+			if (diff == 0)
+			{
+				if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					cell.value = value;
+					cell.sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				return false; // The consumer has not freed this cell yet
+			}
+			else
+			{
+				pos = tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	bool pop(T& value)
+	{
+		Cell& cell = cells[head & MASK];
+		size_t sequence = cell.sequence.load(std::memory_order_acquire);
+		if (sequence != head + 1)
+		{
+			return false; // Empty, or the producer of this cell has not finished writing
+		}
+		value = cell.value;
+		cell.sequence.store(head + Capacity, std::memory_order_release);
+		++head;
+		return true;
+	}
+
+	// Pops every available element and calls f(element) for it. Returns the number of elements.
+	template<typename F>
+	size_t drain(F&& f)
+	{
+		size_t count = 0;
+		T value;
+		while (pop(value))
+		{
+			f(value);
+			++count;
+		}
+		return count;
+	}
+
+private:
+	static constexpr size_t MASK = Capacity - 1;
+
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	alignas(64) std::atomic<size_t> tail{ 0 }; // Next position claimed by a producer
+	alignas(64) size_t head = 0; // Next position read by the consumer
+	alignas(64) Cell cells[Capacity];
+};
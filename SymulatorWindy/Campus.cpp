@@ -0,0 +1,183 @@
+#include "Campus.h"
+#include <algorithm>
+#include <barrier>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <string>
+#include "Trace.h"
+
+namespace
+{
+	struct alignas(64) workerResult
+	{
+		buildingMetrics metrics;
+		double epochEnergy = 0.0; // Energy used by the worker's buildings in the current epoch
+	};
+
+	// Building with a car waiting for the controller at the current tick
+	struct pendingBuilding
+	{
+		BuildingSimulation* building;
+		const controllerState* state;
+	};
+}
+
+Campus::Campus(const campusConfig& config_) : cfg(config_)
+{
+	if (cfg.workers <= 0)
+	{
+		cfg.workers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+	cfg.workers = std::max(1, std::min(cfg.workers, cfg.buildings));
+	if (cfg.building.controller && cfg.building.controllerTick <= 0.0)
+	{
+		cfg.workers = 1; // Buildings ask the one controller connection in turn, whenever a car is ready
+	}
+}
+
+campusMetrics Campus::run()
+{
+	campusMetrics campus;
+	campus.workers = cfg.workers;
+	int epochCount = static_cast<int>(std::ceil(cfg.duration / cfg.epoch));
+	std::vector<workerResult> results(cfg.workers);
+	int epoch = 0;
+
+	// Runs once per epoch, on one thread, after every worker has finished the epoch
+	auto aggregate = [&]() noexcept
+		{
+			double energy = 0.0;
+			for (auto& r : results)
+			{
+				energy += r.epochEnergy;
+			}
+			double epochStart = epoch * cfg.epoch;
+			double epochLength = std::min(cfg.epoch, cfg.duration - epochStart);
+			double demand = epochLength > 0.0 ? energy / (epochLength / 3600.0) : 0.0;
+			if (demand > campus.peakDemand)
+			{
+				campus.peakDemand = demand;
+				campus.peakDemandTime = epochStart;
+			}
+			++epoch;
+		};
+	std::barrier sync(cfg.workers, aggregate);
+
+	// Controller ticks: every worker lists its buildings with a car due at the tick, and
+	// the last worker to arrive decides them all in one batch while the others wait
+	DispatchController* controller = cfg.building.controllerTick > 0.0 ? cfg.building.controller : nullptr;
+	std::vector<std::vector<pendingBuilding>> pending(cfg.workers);
+	std::vector<const controllerState*> states;
+	std::vector<BuildingSimulation*> owners;
+	std::vector<carCommand> commands;
+	bool controllerGone = false;
+	auto decideTick = [&]() noexcept
+		{
+			states.clear();
+			owners.clear();
+			for (auto& list : pending)
+			{
+				for (const pendingBuilding& p : list)
+				{
+					states.push_back(p.state);
+					owners.push_back(p.building);
+				}
+			}
+			if (owners.empty())
+			{
+				return;
+			}
+			commands.clear();
+			controllerGone = controllerGone || !controller->decide(states, commands);
+			std::stable_sort(commands.begin(), commands.end(), [](const carCommand& a, const carCommand& b) { return a.entry < b.entry; });
+			auto from = commands.begin();
+			for (size_t entry = 0; entry < owners.size(); entry++)
+			{
+				auto to = std::find_if(from, commands.end(), [entry](const carCommand& k) { return k.entry != static_cast<int>(entry); });
+				owners[entry]->applyCommands({ from, to }, controllerGone);
+				from = to;
+			}
+		};
+	std::barrier tickSync(cfg.workers, decideTick);
+
+	auto worker = [&](int index)
+		{
+			Trace::setThreadName("worker " + std::to_string(index));
+			// Shard: a contiguous range of buildings, allocated from this thread's own pool
+			int first = static_cast<int>(static_cast<long long>(cfg.buildings) * index / cfg.workers);
+			int last = static_cast<int>(static_cast<long long>(cfg.buildings) * (index + 1) / cfg.workers);
+			std::pmr::unsynchronized_pool_resource arena;
+			std::pmr::vector<BuildingPtr> buildings(&arena);
+			for (int i = first; i < last; i++)
+			{
+				buildingConfig building = cfg.building;
+				building.seed = cfg.seed * 1000003u + static_cast<unsigned>(i);
+				building.buildingId = static_cast<unsigned>(i);
+				buildings.push_back(makeBuilding(building, &arena, cfg.forceDynamic));
+			}
+
+			workerResult& result = results[index];
+			long long tick = 1; // Next controller tick
+			for (int e = 0; e < epochCount; e++)
+			{
+				double epochEnd = std::min(cfg.duration, (e + 1) * cfg.epoch);
+				{
+					TRACE_SCOPE_VALUE("epoch", e);
+					double energyBefore = 0.0;
+					double energyAfter = 0.0;
+					for (auto& b : buildings)
+					{
+						energyBefore += b->metrics().energy;
+					}
+					// Same expression as the cars' ready times, so ticks compare equal
+					for (; controller && static_cast<double>(tick) * cfg.building.controllerTick <= epochEnd; tick++)
+					{
+						double tickTime = static_cast<double>(tick) * cfg.building.controllerTick;
+						pending[index].clear();
+						for (auto& b : buildings)
+						{
+							b->advanceTo(tickTime);
+							if (const controllerState* state = b->pendingDecision())
+							{
+								pending[index].push_back({ b.get(), state });
+							}
+						}
+						tickSync.arrive_and_wait();
+					}
+					for (auto& b : buildings)
+					{
+						b->advanceTo(epochEnd);
+						energyAfter += b->metrics().energy;
+					}
+					result.epochEnergy = energyAfter - energyBefore;
+				}
+				TRACE_SCOPE_VALUE("epochBarrier", e);
+				sync.arrive_and_wait();
+			}
+
+			for (auto& b : buildings)
+			{
+				addMetrics(result.metrics, b->metrics());
+			}
+			buildings.clear(); // Release the buildings before their arena goes away
+		};
+
+	std::vector<std::thread> threads;
+	threads.reserve(cfg.workers);
+	for (int i = 0; i < cfg.workers; i++)
+	{
+		threads.emplace_back(worker, i);
+	}
+	for (auto& t : threads)
+	{
+		t.join();
+	}
+
+	for (auto& r : results)
+	{
+		addMetrics(campus.total, r.metrics);
+	}
+	campus.epochs = epoch;
+	return campus;
+}
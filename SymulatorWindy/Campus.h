@@ -0,0 +1,44 @@
+#pragma once
+#include "Building.h"
+
+// Many independent buildings simulated in parallel. Buildings are split into
+// contiguous shards, one per worker thread; every worker allocates its buildings
+// from its own memory pool. All workers advance in lock-step epochs and the
+// campus-wide metrics are aggregated at every epoch boundary.
+//
+// With an external controller ticking at controllerTick > 0, the workers also stop at
+// every tick: once all have advanced their buildings to it, one thread sends the states
+// of every building with a car due at the tick to the controller in one batch and applies
+// the answers. With tick 0 buildings ask the controller on their own, so the campus runs
+// on one worker.
+
+struct campusConfig
+{
+	int buildings = 200;
+	int workers = 0; // 0 = one worker per hardware thread
+	double duration = 24.0 * 3600.0; // Simulated time in seconds
+	double epoch = 60.0; // Length of one lock-step epoch in seconds
+	unsigned seed = 1;
+	bool forceDynamic = false; // Always use ElevatorEngine, even for small configurations
+	buildingConfig building;
+};
+
+struct campusMetrics
+{
+	buildingMetrics total; // Sum over all buildings
+	double peakDemand = 0.0; // Highest campus-wide power over one epoch (kW)
+	double peakDemandTime = 0.0; // Start of the epoch with the highest demand (s)
+	int epochs = 0;
+	int workers = 0;
+};
+
+class Campus
+{
+public:
+	explicit Campus(const campusConfig& config_);
+
+	campusMetrics run();
+
+private:
+	campusConfig cfg;
+};
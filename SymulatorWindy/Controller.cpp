@@ -0,0 +1,298 @@
+// Controller.cpp : Stand-in external controller for SymulatorWindyHeadless --sterownik.
+// Connects to the simulator's socket and answers every state message with the built-in
+// direction rule (ElevatorEngine::updateDirection without a demand model), multi-deck cars
+// and shared shafts included. With tick 0 a run with it gives the same results as a run
+// without a controller, unless the demand model (--uczenie) moves the parking floor.
+// A starting point for connecting other dispatch engines.
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ControllerLink.h"
+#include "ControllerProtocol.h"
+#include "DispatchRules.h"
+
+namespace
+{
+	struct buildingShape
+	{
+		int floors = 0;
+		int cars = 0;
+		int decks = 1;
+		int carsPerShaft = 1;
+		int capacity = 0; // All decks together
+		dispatchParams dispatch;
+		std::vector<int> minFloor; // [car] range of the car's position, pit and overrun included
+		std::vector<int> maxFloor;
+	};
+
+	struct carInput
+	{
+		int floor = 0;
+		int load = 0;
+		uint8_t flags = 0;
+		std::vector<uint8_t> stops; // [deck * floors + floor]
+	};
+
+	// Per-building memory of the controller: when each car became idle
+	using idleTimes = std::vector<double>;
+
+	class StandInController
+	{
+	public:
+		explicit StandInController(const buildingShape& shape_) : shape(shape_),
+			waitingUp(shape_.floors), waitingDown(shape_.floors), cars(shape_.cars)
+		{
+			for (auto& c : cars)
+			{
+				c.stops.resize(static_cast<size_t>(shape.decks) * shape.floors);
+			}
+		}
+
+		// Decodes one state message and writes the commands message into reply
+		bool answer(const std::vector<uint8_t>& message, std::vector<uint8_t>& reply)
+		{
+			MessageReader in(message.data(), message.size());
+			controllerMessage type{};
+			uint64_t tick = 0;
+			double time = 0.0;
+			uint16_t entries = 0;
+			in.get(type);
+			in.get(tick);
+			in.get(time);
+			in.get(entries);
+			if (!in.valid() || type != controllerMessage::state)
+			{
+				return false;
+			}
+
+			MessageWriter out(reply);
+			out.put(controllerMessage::commands);
+			out.put(uint16_t{ 0 }); // Count, filled in below
+			uint16_t count = 0;
+			for (uint16_t entry = 0; entry < entries; entry++)
+			{
+				uint32_t building = 0;
+				uint32_t ticksElapsed = 0;
+				in.get(building);
+				in.get(ticksElapsed);
+				in.getBits(waitingUp.data(), shape.floors);
+				in.getBits(waitingDown.data(), shape.floors);
+				for (auto& c : cars)
+				{
+					int16_t floor = 0;
+					uint16_t load = 0;
+					in.get(floor);
+					in.get(load);
+					in.get(c.flags);
+					for (int deck = 0; deck < shape.decks; deck++)
+					{
+						in.getBits(c.stops.data() + static_cast<size_t>(deck) * shape.floors, shape.floors);
+					}
+					c.floor = floor;
+					c.load = load;
+				}
+				if (!in.valid())
+				{
+					return false;
+				}
+
+				// Every car of the building is decoded first: a car's reach depends on the other car in its shaft
+				idleTimes& idleSince = idle.try_emplace(building, shape.cars, -1.0).first->second;
+				for (int i = 0; i < shape.cars; i++)
+				{
+					if (cars[i].flags & CAR_DECIDING)
+					{
+						bool goingUp = (cars[i].flags & CAR_GOING_UP) != 0;
+						int step = decide(i, goingUp, time, idleSince[i]);
+						out.put(entry);
+						out.put(static_cast<uint16_t>(i));
+						out.put(static_cast<int8_t>(step));
+						out.put(static_cast<uint8_t>(goingUp));
+						++count;
+					}
+				}
+			}
+			std::memcpy(reply.data() + 1, &count, sizeof(count));
+			return true;
+		}
+
+	private:
+		buildingShape shape;
+		std::vector<uint8_t> waitingUp;
+		std::vector<uint8_t> waitingDown;
+		std::vector<carInput> cars;
+		std::unordered_map<uint32_t, idleTimes> idle;
+
+		// Other car in the same shaft, -1 if none; consecutive cars share a shaft
+		int sibling(int car) const
+		{
+			int first = car - car % shape.carsPerShaft;
+			if (std::min(shape.carsPerShaft, shape.cars - first) < 2)
+			{
+				return -1;
+			}
+			return car == first ? car + 1 : car - 1;
+		}
+
+		// Range of positions the car can reach without running into the other car of its shaft
+		int lowestReachable(int car) const
+		{
+			int other = sibling(car);
+			return other >= 0 && other < car ? cars[other].floor + shape.decks : shape.minFloor[car];
+		}
+
+		int highestReachable(int car) const
+		{
+			int other = sibling(car);
+			return other > car ? cars[other].floor - shape.decks : shape.maxFloor[car];
+		}
+
+		// True if one of the decks is at the given floor for some car position in [from, to]
+		bool reachesFloor(int floor, int from, int to) const
+		{
+			return floor >= from && floor - (shape.decks - 1) <= to;
+		}
+
+		int decide(int car, bool& goingUp, double time, double& idleSince) const
+		{
+			const carInput& c = cars[car];
+			int lowest = lowestReachable(car);
+			int highest = highestReachable(car);
+			bool hasAbove = false;
+			bool hasBelow = false;
+			if (acceptsCalls(c.load, shape.capacity, shape.dispatch))
+			{
+				for (int f = 0; f < shape.floors; f++)
+				{
+					bool calling = waitingUp[f] || waitingDown[f];
+					hasAbove = hasAbove || (calling && f > c.floor && reachesFloor(f, c.floor + 1, highest));
+					hasBelow = hasBelow || (calling && f >= lowest && f < c.floor + shape.decks - 1 && reachesFloor(f, lowest, c.floor - 1));
+				}
+			}
+			for (int deck = 0; deck < shape.decks; deck++)
+			{
+				for (int f = 0; f < shape.floors; f++)
+				{
+					// The deck reaches floor f with the car at f - deck
+					bool stop = c.stops[static_cast<size_t>(deck) * shape.floors + f] != 0;
+					hasAbove = hasAbove || (stop && f - deck > c.floor);
+					hasBelow = hasBelow || (stop && f - deck < c.floor);
+				}
+			}
+			bool isIdle = false;
+			int step = decideStep(goingUp, hasAbove, hasBelow, c.load == 0, isIdle);
+			if (isIdle)
+			{
+				if (idleSince < 0.0)
+				{
+					idleSince = time;
+				}
+				step = idleStep(goingUp, c.floor, time - idleSince, shape.dispatch, std::clamp(0, lowest, highest));
+			}
+			else
+			{
+				idleSince = -1.0;
+			}
+			// The simulator keeps the car apart from the other car in its shaft and within its range
+			return step;
+		}
+	};
+
+	bool readHello(const std::vector<uint8_t>& message, buildingShape& shape)
+	{
+		MessageReader in(message.data(), message.size());
+		controllerMessage type{};
+		uint16_t version = 0, floors = 0, cars = 0, capacity = 0;
+		uint8_t decks = 0, carsPerShaft = 0, callReserve = 0, idleReverse = 0;
+		float idleThreshold = 0.0f, tick = 0.0f;
+		in.get(type);
+		in.get(version);
+		in.get(floors);
+		in.get(cars);
+		in.get(decks);
+		in.get(carsPerShaft);
+		in.get(capacity);
+		in.get(callReserve);
+		in.get(idleReverse);
+		in.get(idleThreshold);
+		in.get(tick);
+		if (!in.valid() || type != controllerMessage::hello || version != CONTROLLER_PROTOCOL_VERSION
+			|| decks == 0 || carsPerShaft == 0)
+		{
+			return false;
+		}
+		shape.floors = floors;
+		shape.cars = cars;
+		shape.decks = decks;
+		shape.carsPerShaft = carsPerShaft;
+		shape.capacity = capacity * decks;
+		shape.dispatch.callReserve = callReserve;
+		shape.dispatch.idleReverse = idleReverse != 0;
+		shape.dispatch.idleThreshold = idleThreshold;
+		for (int i = 0; i < cars; i++)
+		{
+			int16_t minFloor = 0, maxFloor = 0;
+			in.get(minFloor);
+			in.get(maxFloor);
+			shape.minFloor.push_back(minFloor);
+			shape.maxFloor.push_back(maxFloor);
+		}
+		return in.valid();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 2 || std::string(argv[1]) == "--pomoc" || std::string(argv[1]) == "-h")
+	{
+		std::cout << "Uzycie: SymulatorWindyController <gniazdo>\n"
+			<< "  Laczy sie z SymulatorWindyHeadless --sterownik <gniazdo> i steruje windami\n"
+			<< "  wedlug wbudowanej reguly kierunku.\n";
+		return argc == 2 ? 0 : 1;
+	}
+
+	ControllerLink link;
+	if (!link.connect(argv[1]))
+	{
+		std::cerr << link.error() << "\n";
+		return 1;
+	}
+	std::vector<uint8_t> message;
+	std::vector<uint8_t> reply;
+	buildingShape shape;
+	if (!link.receive(message) || !readHello(message, shape))
+	{
+		std::cerr << "Nieprawidlowe powitanie symulatora\n";
+		return 1;
+	}
+	MessageWriter hello(reply);
+	hello.put(controllerMessage::hello);
+	hello.put(CONTROLLER_PROTOCOL_VERSION);
+	if (!link.send(reply))
+	{
+		std::cerr << link.error() << "\n";
+		return 1;
+	}
+
+	StandInController controller(shape);
+	uint64_t rounds = 0;
+	while (link.receive(message))
+	{
+		if (!message.empty() && static_cast<controllerMessage>(message[0]) == controllerMessage::bye)
+		{
+			std::cout << "Sterownik: " << rounds << " rund\n";
+			return 0;
+		}
+		if (!controller.answer(message, reply) || !link.send(reply))
+		{
+			std::cerr << "Nieprawidlowy komunikat symulatora\n";
+			return 1;
+		}
+		++rounds;
+	}
+	std::cerr << "Symulator zamknal polaczenie\n";
+	return 1;
+}
@@ -0,0 +1,171 @@
+#include "ControllerLink.h"
+#include "ControllerProtocol.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+	bool makeAddress(const std::string& path, sockaddr_un& address)
+	{
+		address = {};
+		address.sun_family = AF_UNIX;
+		if (path.empty() || path.size() >= sizeof(address.sun_path))
+		{
+			return false;
+		}
+		std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+		return true;
+	}
+}
+
+ControllerLink::~ControllerLink()
+{
+	close();
+}
+
+bool ControllerLink::listen(const std::string& path)
+{
+	close();
+	sockaddr_un address;
+	if (!makeAddress(path, address))
+	{
+		lastError = "Nieprawidlowa sciezka gniazda: " + path;
+		return false;
+	}
+	int listener = ::socket(AF_UNIX, SOCK_SEQPACKET, 0);
+	if (listener < 0)
+	{
+		return fail("socket");
+	}
+	::unlink(path.c_str());
+	if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || ::listen(listener, 1) < 0)
+	{
+		fail("bind " + path);
+		::close(listener);
+		return false;
+	}
+	socket = ::accept(listener, nullptr, nullptr);
+	if (socket < 0)
+	{
+		fail("accept");
+	}
+	::close(listener);
+	::unlink(path.c_str()); // The connection stays open; nobody else may connect
+	return socket >= 0;
+}
+
+bool ControllerLink::connect(const std::string& path)
+{
+	close();
+	sockaddr_un address;
+	if (!makeAddress(path, address))
+	{
+		lastError = "Nieprawidlowa sciezka gniazda: " + path;
+		return false;
+	}
+	socket = ::socket(AF_UNIX, SOCK_SEQPACKET, 0);
+	if (socket < 0)
+	{
+		return fail("socket");
+	}
+	if (::connect(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+	{
+		fail("connect " + path);
+		close();
+		return false;
+	}
+	return true;
+}
+
+void ControllerLink::close()
+{
+	if (socket >= 0)
+	{
+		::close(socket);
+		socket = -1;
+	}
+}
+
+bool ControllerLink::send(const std::vector<uint8_t>& message)
+{
+	ssize_t sent = ::send(socket, message.data(), message.size(), MSG_NOSIGNAL);
+	if (sent != static_cast<ssize_t>(message.size()))
+	{
+		return fail("send");
+	}
+	return true;
+}
+
+bool ControllerLink::receive(std::vector<uint8_t>& message)
+{
+	message.resize(CONTROLLER_MAX_MESSAGE);
+	// Polling only pays off when the other end runs on another core
+	static const int spinPolls = std::thread::hardware_concurrency() > 1 ? CONTROLLER_SPIN_POLLS : 0;
+	ssize_t received = -1;
+	errno = EAGAIN;
+	for (int i = 0; i < spinPolls; i++)
+	{
+		received = ::recv(socket, message.data(), message.size(), MSG_DONTWAIT);
+		if (received >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+		{
+			break;
+		}
+	}
+	if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+	{
+		received = ::recv(socket, message.data(), message.size(), 0);
+	}
+	if (received <= 0)
+	{
+		message.clear();
+		return received == 0 ? false : fail("recv");
+	}
+	message.resize(static_cast<size_t>(received));
+	return true;
+}
+
+bool ControllerLink::fail(const std::string& what)
+{
+	lastError = errno ? what + ": " + std::strerror(errno) : what;
+	return false;
+}
+
+#else
+
+ControllerLink::~ControllerLink() = default;
+
+bool ControllerLink::listen(const std::string&)
+{
+	return fail("Sterownik zewnetrzny wymaga gniazd Unix (SOCK_SEQPACKET)");
+}
+
+bool ControllerLink::connect(const std::string&)
+{
+	return fail("Sterownik zewnetrzny wymaga gniazd Unix (SOCK_SEQPACKET)");
+}
+
+void ControllerLink::close() {}
+
+bool ControllerLink::send(const std::vector<uint8_t>&)
+{
+	return false;
+}
+
+bool ControllerLink::receive(std::vector<uint8_t>&)
+{
+	return false;
+}
+
+bool ControllerLink::fail(const std::string& what)
+{
+	lastError = what;
+	return false;
+}
+
+#endif
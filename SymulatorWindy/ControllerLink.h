@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One end of a local SOCK_SEQPACKET socket carrying ControllerProtocol messages.
+// The simulator listens on a socket path and the controller connects to it. On multi-core
+// machines receiving polls the socket for a short while before blocking, so a quick
+// answer is picked up without a scheduler round trip. Available on POSIX systems only;
+// elsewhere every call fails with an error message.
+
+constexpr int CONTROLLER_SPIN_POLLS = 20000; // Non-blocking receive attempts before a blocking one
+
+class ControllerLink
+{
+public:
+	ControllerLink() = default;
+	~ControllerLink();
+
+	ControllerLink(const ControllerLink&) = delete;
+	ControllerLink& operator=(const ControllerLink&) = delete;
+
+	// Creates the socket at path and waits for one controller to connect
+	bool listen(const std::string& path);
+	bool connect(const std::string& path);
+	void close();
+
+	bool send(const std::vector<uint8_t>& message);
+	// Replaces message with the next packet; false if the other end is gone
+	bool receive(std::vector<uint8_t>& message);
+
+	bool isOpen() const { return socket >= 0; }
+	const std::string& error() const { return lastError; }
+
+private:
+	int socket = -1;
+	std::string lastError;
+
+	bool fail(const std::string& what);
+};
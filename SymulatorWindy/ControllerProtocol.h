@@ -0,0 +1,143 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Binary protocol between the simulator and an external controller over a local
+// SOCK_SEQPACKET socket, one protocol message per packet. Both ends run on the same
+// machine, so values are written in host byte order without padding.
+//
+//   hello    simulator -> controller  u8 type, u16 version, u16 floors, u16 cars, u8 decks,
+//                                     u8 carsPerShaft, u16 capacity, u8 callReserve,
+//                                     u8 idleReverse, f32 idleThreshold, f32 tick,
+//                                     per car: i16 minFloor, i16 maxFloor
+//   hello    controller -> simulator  u8 type, u16 version
+//   state    simulator -> controller  u8 type, u64 tick, f64 time, u16 entries,
+//                                     per entry: u32 building, u32 ticksElapsed,
+//                                                waitingUp bits, waitingDown bits,
+//                                                per car: i16 floor, u16 load, u8 flags,
+//                                                         per deck: stop bits
+//   commands controller -> simulator  u8 type, u16 count,
+//                                     per command: u16 entry, u16 car, i8 step, u8 goingUp
+//   bye      simulator -> controller  u8 type
+// Bit sets hold one bit per floor, (floors + 7) / 8 bytes, floor 0 in the lowest bit.
+//
+// Every state message is answered by one commands message before the next is sent. A
+// state message has one entry per building with a car to decide (CAR_DECIDING); a
+// command names the entry by its position in that message and may only move a deciding
+// car, at most once per entry, by one floor within its minFloor..maxFloor. Anything else is a protocol error and
+// ends the connection. With a tick above 0 all buildings due at a tick are batched: they
+// go in one state message, or in as few as CONTROLLER_MAX_MESSAGE allows, in order. With
+// tick 0 a building is sent alone as soon as one of its cars is ready, and the buildings
+// are simulated on one thread.
+//
+// Capacity is per deck; load counts the passengers on all decks. A car's floor is the
+// position of its lowest deck, so deck d serves floor + d; the stop bits of deck d mark
+// the floors where passengers on that deck get off. Consecutive cars share a shaft,
+// carsPerShaft at a time (the last shaft may hold fewer). minFloor and maxFloor bound the
+// car's position and reach below floor 0 and above the top floor where the shaft has a
+// pit and an overrun. A car never comes within decks floors of the other car in its shaft.
+
+constexpr uint16_t CONTROLLER_PROTOCOL_VERSION = 3;
+constexpr size_t CONTROLLER_MAX_MESSAGE = 65536; // Largest packet either side sends
+constexpr int CONTROLLER_MAX_FLOORS = 1024;
+constexpr int CONTROLLER_MAX_CARS = 256;
+
+enum class controllerMessage : uint8_t
+{
+	hello = 1,
+	state = 2,
+	commands = 3,
+	bye = 4,
+};
+
+constexpr uint8_t CAR_GOING_UP = 1;
+constexpr uint8_t CAR_DECIDING = 2;
+constexpr uint8_t CAR_DWELLING = 4;
+
+inline size_t floorBitBytes(int floors) { return (static_cast<size_t>(floors) + 7) / 8; }
+
+constexpr size_t STATE_HEADER_BYTES = 1 + 8 + 8 + 2;
+
+// Bytes of one entry of a state message
+inline size_t stateEntrySize(int floors, int cars, int decks)
+{
+	size_t header = 4 + 4 + 2 * floorBitBytes(floors);
+	return header + static_cast<size_t>(cars) * (2 + 2 + 1 + decks * floorBitBytes(floors));
+}
+
+class MessageWriter
+{
+public:
+	explicit MessageWriter(std::vector<uint8_t>& buffer_) : buffer(buffer_) { buffer.clear(); }
+
+	template<typename T>
+	void put(T value)
+	{
+		size_t at = buffer.size();
+		buffer.resize(at + sizeof(T));
+		std::memcpy(buffer.data() + at, &value, sizeof(T));
+	}
+
+	// Appends values[0..count) as a bit set
+	void putBits(const uint8_t* values, int count)
+	{
+		size_t at = buffer.size();
+		buffer.resize(at + floorBitBytes(count), 0);
+		for (int i = 0; i < count; i++)
+		{
+			if (values[i])
+			{
+				buffer[at + i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+			}
+		}
+	}
+
+private:
+	std::vector<uint8_t>& buffer;
+};
+
+class MessageReader
+{
+public:
+	MessageReader(const uint8_t* data_, size_t size_) : data(data_), size(size_) {}
+
+	// Returns false once the message is too short; the value is then left unchanged
+	template<typename T>
+	bool get(T& value)
+	{
+		if (size - position < sizeof(T))
+		{
+			ok = false;
+			return false;
+		}
+		std::memcpy(&value, data + position, sizeof(T));
+		position += sizeof(T);
+		return true;
+	}
+
+	// Reads a bit set of count floors into values[0..count)
+	bool getBits(uint8_t* values, int count)
+	{
+		size_t bytes = floorBitBytes(count);
+		if (size - position < bytes)
+		{
+			ok = false;
+			return false;
+		}
+		for (int i = 0; i < count; i++)
+		{
+			values[i] = (data[position + i / 8] >> (i % 8)) & 1u;
+		}
+		position += bytes;
+		return true;
+	}
+
+	bool valid() const { return ok; }
+
+private:
+	const uint8_t* data;
+	size_t size;
+	size_t position = 0;
+	bool ok = true;
+};
@@ -0,0 +1,172 @@
+#include "DemandModel.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+DemandModel::DemandModel(int floors, std::pmr::memory_resource* memory)
+	: floorCount(floors),
+	trips(static_cast<size_t>(DEMAND_SLOTS) * floors * floors, 0.0f, memory),
+	origins(static_cast<size_t>(DEMAND_SLOTS) * floors, 0.0f, memory),
+	slots(floors > 0 ? DEMAND_SLOTS : 0, memory)
+{
+}
+
+void DemandModel::observe(double time, int origin, int destination)
+{
+	if (floorCount == 0 || time < 0.0)
+	{
+		return;
+	}
+	int slot = slotOf(time);
+	long long day = dayOf(time);
+	if (day != slots[slot].day)
+	{
+		startDay(slot, day);
+	}
+
+	trips[(static_cast<size_t>(slot) * floorCount + origin) * floorCount + destination] += 1.0f;
+	origins[static_cast<size_t>(slot) * floorCount + origin] += 1.0f;
+	rank(slot, origin);
+}
+
+double DemandModel::originRate(double time, int origin) const
+{
+	if (floorCount == 0)
+	{
+		return 0.0;
+	}
+	int slot = slotOf(time);
+	return perHour(slots[slot], origins[static_cast<size_t>(slot) * floorCount + origin], time);
+}
+
+double DemandModel::tripRate(double time, int origin, int destination) const
+{
+	if (floorCount == 0)
+	{
+		return 0.0;
+	}
+	int slot = slotOf(time);
+	return perHour(slots[slot], trips[(static_cast<size_t>(slot) * floorCount + origin) * floorCount + destination], time);
+}
+
+int DemandModel::busiestOrigin(double time, int fallback) const
+{
+	if (floorCount == 0)
+	{
+		return fallback;
+	}
+	int slot = slotOf(time);
+	const slotState& state = slots[slot];
+	if (state.ranked > 0 && perHour(state, origins[static_cast<size_t>(slot) * floorCount + state.top[0]], time) >= DEMAND_MIN_RATE)
+	{
+		return state.top[0];
+	}
+	return fallback;
+}
+
+void DemandModel::busiestOrigins(double time, int count, std::vector<int>& out) const
+{
+	out.clear();
+	if (floorCount == 0)
+	{
+		return;
+	}
+	int slot = slotOf(time);
+	const slotState& state = slots[slot];
+	const float* counts = &origins[static_cast<size_t>(slot) * floorCount];
+	for (int i = 0; i < state.ranked && i < count; i++)
+	{
+		if (perHour(state, counts[state.top[i]], time) < DEMAND_MIN_RATE)
+		{
+			break; // Ranked, so the rest are quieter still
+		}
+		out.push_back(state.top[i]);
+	}
+}
+
+int DemandModel::slotOf(double time)
+{
+	double timeOfDay = std::fmod(time, DEMAND_DAY);
+	if (timeOfDay < 0.0)
+	{
+		timeOfDay += DEMAND_DAY;
+	}
+	int slot = static_cast<int>(timeOfDay / DEMAND_SLOT_LENGTH);
+	return slot < DEMAND_SLOTS ? slot : DEMAND_SLOTS - 1;
+}
+
+long long DemandModel::dayOf(double time)
+{
+	return static_cast<long long>(std::floor(time / DEMAND_DAY));
+}
+
+double DemandModel::emptyDaysWeight(long long days)
+{
+	return days > 0 ? (1.0 - std::pow(DEMAND_DECAY, static_cast<double>(days))) / (1.0 - DEMAND_DECAY) : 0.0;
+}
+
+// Ages the slot's counts by the days since its last call, before the first call of a new day
+void DemandModel::startDay(int slot, long long day)
+{
+	slotState& state = slots[slot];
+	if (state.day >= 0)
+	{
+		long long elapsed = day - state.day;
+		double decay = std::pow(DEMAND_DECAY, static_cast<double>(elapsed));
+		size_t first = static_cast<size_t>(slot) * floorCount;
+		for (size_t i = first * floorCount; i < (first + floorCount) * floorCount; i++)
+		{
+			trips[i] = static_cast<float>(trips[i] * decay);
+		}
+		for (size_t i = first; i < first + floorCount; i++)
+		{
+			origins[i] = static_cast<float>(origins[i] * decay);
+		}
+		state.weight = state.weight * decay + DEMAND_DECAY * emptyDaysWeight(elapsed - 1);
+	}
+	state.weight += 1.0;
+	state.day = day;
+}
+
+// Moves origin, whose count has just grown, to its place among the slot's busiest origins
+void DemandModel::rank(int slot, int origin)
+{
+	slotState& state = slots[slot];
+	const float* counts = &origins[static_cast<size_t>(slot) * floorCount];
+	auto busier = [counts](int a, int b) { return counts[a] != counts[b] ? counts[a] > counts[b] : a < b; };
+	int at = static_cast<int>(std::find(state.top.begin(), state.top.begin() + state.ranked, origin) - state.top.begin());
+	if (at == state.ranked)
+	{
+		if (state.ranked < DEMAND_TOP_ORIGINS)
+		{
+			++state.ranked;
+		}
+		else if (busier(origin, state.top[at - 1]))
+		{
+			--at; // Takes the place of the quietest ranked origin
+		}
+		else
+		{
+			return;
+		}
+		state.top[at] = origin;
+	}
+	for (; at > 0 && busier(state.top[at], state.top[at - 1]); at--)
+	{
+		std::swap(state.top[at], state.top[at - 1]);
+	}
+}
+
+double DemandModel::perHour(const slotState& slot, float count, double time) const
+{
+	double weight = slot.weight;
+	double aged = count;
+	long long missed = slot.day >= 0 ? dayOf(time) - slot.day - 1 : 0;
+	if (missed > 0)
+	{
+		double decay = std::pow(DEMAND_DECAY, static_cast<double>(missed));
+		weight = weight * decay + emptyDaysWeight(missed);
+		aged *= decay;
+	}
+	return weight > 0.0 ? aged / weight * (3600.0 / DEMAND_SLOT_LENGTH) : 0.0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <memory_resource>
+#include <vector>
+
+// Online model of the passenger demand by time of day, learnt from the observed calls.
+//
+// The day is split into DEMAND_SLOTS slots. For every slot the model keeps an
+// origin-destination matrix of call counts; when the first call of a new day arrives
+// in a slot, the slot's counts are multiplied by DEMAND_DECAY for every day that passed,
+// so recent days weigh more, and days without calls count as days with none. Queries
+// age the slot the same way for the days missed since its last call, so a slot whose
+// calls stopped fades out instead of keeping its old busiest origins. Memory is fixed by
+// the number of floors. Every query is O(1) in the number of floors: the
+// DEMAND_TOP_ORIGINS busiest origins of each slot are kept ranked on every call (decay
+// scales all counts of a slot alike, so it never changes the order).
+
+constexpr double DEMAND_DAY = 24.0 * 3600.0;
+constexpr int DEMAND_SLOTS = 96; // 15-minute slots
+constexpr double DEMAND_SLOT_LENGTH = DEMAND_DAY / DEMAND_SLOTS;
+constexpr double DEMAND_DECAY = 0.8; // Weight of the previous day's counts
+constexpr double DEMAND_LOOKAHEAD = 300.0; // Seconds ahead an idle car looks when choosing where to park
+constexpr int DEMAND_TOP_ORIGINS = 8; // Busiest origins ranked per slot
+constexpr double DEMAND_MIN_RATE = 1.0; // Calls per hour below which an origin is not reported as busy
+
+class DemandModel
+{
+public:
+	// floors == 0 gives an empty model that ignores calls
+	explicit DemandModel(int floors, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+	// time is in seconds; day n covers [n * DEMAND_DAY, (n + 1) * DEMAND_DAY)
+	void observe(double time, int origin, int destination);
+
+	// Expected calls per hour at the given time of day, averaged over the decayed days
+	double originRate(double time, int origin) const;
+	double tripRate(double time, int origin, int destination) const;
+	// Floor with the most calls at the given time of day, or fallback if no floor expects
+	// DEMAND_MIN_RATE calls per hour
+	int busiestOrigin(double time, int fallback) const;
+	// Replaces out with up to min(count, DEMAND_TOP_ORIGINS) floors expecting at least
+	// DEMAND_MIN_RATE calls per hour at the given time of day, busiest first (the lower
+	// floor first on ties)
+	void busiestOrigins(double time, int count, std::vector<int>& out) const;
+
+	bool empty() const { return floorCount == 0; }
+
+private:
+	struct slotState
+	{
+		long long day = -1; // Last day with a call in this slot
+		double weight = 0.0; // Decayed number of days up to the last one with calls
+		std::array<int, DEMAND_TOP_ORIGINS> top{}; // Busiest origins, the first ranked in use
+		int ranked = 0;
+	};
+
+	int floorCount;
+	std::pmr::vector<float> trips; // [slot][origin][destination]
+	std::pmr::vector<float> origins; // [slot][origin]
+	std::pmr::vector<slotState> slots;
+
+	static int slotOf(double time);
+	static long long dayOf(double time);
+	// Weight of days without calls, the latest of them weighing 1
+	static double emptyDaysWeight(long long days);
+	void startDay(int slot, long long day);
+	void rank(int slot, int origin);
+	// Calls per hour for the slot's count, aged by the days without calls before time
+	double perHour(const slotState& slot, float count, double time) const;
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Interface of a dispatcher outside the engine. When buildingConfig::controller is set,
+// ElevatorEngine does not pick the direction of a departing car itself: every car that
+// is ready to depart waits for the next controller tick, and all cars due at that tick
+// are decided in one call. With a tick length above 0 the campus steps all buildings
+// from tick to tick, and one call decides the cars of every building due at the tick;
+// with tick 0 a building asks alone whenever one of its cars is ready.
+
+struct carStatus
+{
+	int floor; // Position of the lowest deck, may be in the pit or overrun of the shaft
+	int load; // Passengers on all decks
+	bool goingUp;
+	bool deciding; // Waits for a command in this call
+	bool dwelling; // Stopped with the doors open or closing
+};
+
+struct controllerState
+{
+	unsigned building = 0;
+	uint64_t tick = 0; // Tick index, or decision round when the tick length is 0
+	uint32_t ticksElapsed = 0; // Ticks since the previous call for this building
+	double time = 0.0; // Simulated time in seconds
+	std::vector<uint8_t> waitingUp; // [floor] 1 if a passenger waits to go up
+	std::vector<uint8_t> waitingDown;
+	std::vector<carStatus> cars;
+	std::vector<uint8_t> stops; // [(car * decks + deck) * floors + floor] 1 if a passenger on that deck goes there
+};
+
+struct carCommand
+{
+	int entry; // Position of the building's state in the decide() call
+	int car;
+	int step; // -1, 0 or +1
+	bool goingUp; // Direction after the step
+};
+
+class DispatchController
+{
+public:
+	virtual ~DispatchController() = default;
+
+	// Appends at most one command per deciding car of every listed building. Returns false
+	// if the controller is gone or misbehaved; the engines then fall back to their own rule.
+	virtual bool decide(std::span<const controllerState* const> states, std::vector<carCommand>& commands) = 0;
+};
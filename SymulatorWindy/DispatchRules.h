@@ -0,0 +1,74 @@
+#pragma once
+#include "Simulation.h"
+
+// Direction rules of ElevatorLogic::updateDirection and handleIdleBehavior, shared by
+// the headless engines. Each returns the floor step of the car: -1, 0 or +1.
+
+// Keep going while there are calls ahead, otherwise turn around. Sets idle when the
+// car is empty and there is nothing to serve in either direction.
+inline int decideStep(bool& goingUp, bool hasAbove, bool hasBelow, bool empty, bool& idle)
+{
+	idle = false;
+	if (goingUp)
+	{
+		if (hasAbove)
+		{
+			return 1;
+		}
+		if (hasBelow)
+		{
+			goingUp = false;
+			return -1;
+		}
+	}
+	else // going down
+	{
+		if (hasBelow)
+		{
+			return -1;
+		}
+		if (hasAbove)
+		{
+			goingUp = true;
+			return 1;
+		}
+	}
+	idle = empty;
+	return 0;
+}
+
+// True while the car has room to answer calls from other floors
+inline bool acceptsCalls(int load, int capacity, const dispatchParams& params)
+{
+	return load + params.callReserve < capacity;
+}
+
+// parkingFloor is where an idle car waits for the next call, the ground floor unless a
+// demand model predicts calls elsewhere
+inline int idleStep(bool& goingUp, int floor, double timeSinceStop, const dispatchParams& params, int parkingFloor = 0)
+{
+	if (timeSinceStop >= params.idleThreshold && floor != parkingFloor)
+	{
+		// Go to the parking floor after idle time
+		goingUp = parkingFloor > floor;
+		return goingUp ? 1 : -1;
+	}
+	if (timeSinceStop < params.idleThreshold && params.idleReverse)
+	{
+		// Briefly reverse direction to look for calls
+		goingUp = !goingUp;
+	}
+	return 0;
+}
+
+inline void clampDirection(bool& goingUp, int floor, int floors)
+{
+	if (floor == 0)
+	{
+		goingUp = true; // Always go up from ground floor
+	}
+	else if (floor == floors - 1)
+	{
+		goingUp = false; // Always go down from top floor
+	}
+}
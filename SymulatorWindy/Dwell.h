@@ -0,0 +1,42 @@
+#pragma once
+#include <algorithm>
+
+// Dwell time of a car at a stop, in simulated seconds, shared by the GUI and the headless
+// engines. The door opens, passengers alight and board one after another, and the door
+// closes after the last one. A passenger arriving while the door is closing makes it
+// reopen. Transfers get slower as the car fills up.
+
+constexpr double DOOR_OPEN_TIME = 2.0; // Seconds needed to open the door
+constexpr double DOOR_CLOSE_TIME = 2.0; // Seconds needed to close the door
+constexpr double TRANSFER_TIME = 1.5; // Seconds needed by one passenger to board or alight an empty car
+constexpr double CROWDING_SLOWDOWN = 0.5; // Extra transfer time in a full car, as a fraction of TRANSFER_TIME
+
+inline double transferTime(int load, int capacity)
+{
+	return TRANSFER_TIME * (1.0 + CROWDING_SLOWDOWN * static_cast<double>(load) / capacity);
+}
+
+// Door of one deck during one stop
+struct doorCycle
+{
+	bool active = false; // The door opened at this stop
+	double closingAt = 0.0; // The door starts to close once the last passenger is through
+
+	// One passenger boards or alights at time now; load is the deck's load before the transfer
+	void transfer(double now, int load, int capacity)
+	{
+		if (!active)
+		{
+			active = true;
+			closingAt = now + DOOR_OPEN_TIME;
+		}
+		else if (now > closingAt)
+		{
+			// Reopening takes as long as the door has been closing
+			closingAt = now + std::min(now - closingAt, DOOR_CLOSE_TIME);
+		}
+		closingAt += transferTime(load, capacity);
+	}
+
+	double closedAt() const { return closingAt + DOOR_CLOSE_TIME; }
+};
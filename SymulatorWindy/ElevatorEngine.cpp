@@ -0,0 +1,540 @@
+#include "ElevatorEngine.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include "DispatchRules.h"
+#include "JourneyLog.h"
+
+ElevatorEngine::ElevatorEngine(const buildingConfig& config_, std::pmr::memory_resource* memory_)
+	: cfg(config_), memory(memory_), allocator(memory_), traffic(config_),
+	demand(config_.learnDemand ? config_.floors : 0, memory_), floorPassengers(memory_), cars(memory_)
+{
+	floorPassengers.reserve(cfg.floors);
+	for (int i = 0; i < cfg.floors; i++)
+	{
+		floorPassengers.emplace_back(i, cfg.floors, memory);
+	}
+	cfg.decks = std::clamp(cfg.decks, 1, MAX_DECKS);
+	cfg.carsPerShaft = std::clamp(cfg.carsPerShaft, 1, MAX_CARS_PER_SHAFT);
+	cars.reserve(cfg.cars);
+	for (int i = 0; i < cfg.cars; i++)
+	{
+		cars.emplace_back(memory);
+		car& c = cars.back();
+		c.id = i;
+		c.passengers.reserve(static_cast<size_t>(cfg.capacity) * cfg.decks);
+
+		carShaft shaft = shaftOf(cfg, i);
+		c.minFloor = shaft.minFloor;
+		c.maxFloor = shaft.maxFloor;
+		c.floor = shaft.startFloor;
+		c.sibling = shaft.sibling;
+		c.upper = shaft.upper;
+	}
+	boardedScratch.reserve(cfg.capacity);
+}
+
+ElevatorEngine::~ElevatorEngine()
+{
+	for (auto& queue : floorPassengers)
+	{
+		queue.forEach([this](passenger* p) { allocator.delete_object(p); });
+	}
+	for (auto& c : cars)
+	{
+		for (auto* p : c.passengers)
+		{
+			allocator.delete_object(p);
+		}
+	}
+}
+
+void ElevatorEngine::advanceTo(double endTime)
+{
+	while (true)
+	{
+		car* next = nullptr;
+		bool leaveWaiting = ticked(); // Campus decides the cars waiting at a tick
+		for (auto& c : cars)
+		{
+			if ((!next || c.readyAt < next->readyAt) && !(leaveWaiting && c.awaitingCommand))
+			{
+				next = &c;
+			}
+		}
+		double carTime = next ? next->readyAt : std::numeric_limits<double>::infinity();
+		if (traffic.nextArrival() <= carTime)
+		{
+			if (traffic.nextArrival() > endTime)
+			{
+				break;
+			}
+			now = traffic.nextArrival();
+			spawnPassenger();
+		}
+		else
+		{
+			if (carTime > endTime)
+			{
+				break;
+			}
+			now = carTime;
+			if (next->awaitingCommand)
+			{
+				commandCars();
+			}
+			else
+			{
+				serveCar(*next);
+			}
+		}
+	}
+	now = endTime;
+}
+
+void ElevatorEngine::view(buildingView& out) const
+{
+	out.time = now;
+	out.cars.resize(cars.size());
+	for (size_t i = 0; i < cars.size(); i++)
+	{
+		const car& c = cars[i];
+		carView& v = out.cars[i];
+		v.floor = c.floor;
+		v.goingUp = c.goingUp;
+		v.dwelling = c.dwelling;
+		v.riders.clear();
+		for (auto* p : c.passengers)
+		{
+			v.riders.push_back(p->destination);
+		}
+	}
+	out.waiting.resize(floorPassengers.size());
+	for (size_t i = 0; i < floorPassengers.size(); i++)
+	{
+		auto& waiting = out.waiting[i];
+		waiting.clear();
+		floorPassengers[i].forEach([&waiting](passenger* p) { waiting.push_back(p->destination); });
+	}
+}
+
+void ElevatorEngine::addUnserved(buildingMetrics& metrics) const
+{
+	for (const auto& queue : floorPassengers)
+	{
+		queue.forEach([&](const passenger* p)
+			{
+				metrics.totalWait += now - p->arrivalTime;
+				recordWait(metrics, now - p->arrivalTime);
+				++metrics.unserved;
+			});
+	}
+}
+
+void ElevatorEngine::spawnPassenger()
+{
+	trafficCall call = traffic.pop();
+	passenger* p = allocator.new_object<passenger>(call.startFloor, call.destination, false, nextPassengerId++, now);
+	if (!boardStandingCar(p))
+	{
+		floorPassengers[call.startFloor].push(p);
+	}
+	demand.observe(now, call.startFloor, call.destination);
+	++stats.arrived;
+}
+
+// A passenger arriving while a car going their way stands at the floor walks straight in,
+// reopening the door if it is already closing
+bool ElevatorEngine::boardStandingCar(passenger* p)
+{
+	bool upward = p->destination > p->startFloor;
+	for (auto& c : cars)
+	{
+		int deck = p->startFloor - c.floor;
+		if (c.dwelling && c.goingUp == upward && deck >= 0 && deck < cfg.decks && c.deckLoad[deck] < cfg.capacity)
+		{
+			board(c, deck, p);
+			c.readyAt = std::max(c.readyAt, c.doors[deck].closedAt());
+			return true;
+		}
+	}
+	return false;
+}
+
+void ElevatorEngine::serveCar(car& c)
+{
+	if (!c.dwelling)
+	{
+		// 1. Unload and 2. load passengers at the floor of every deck; each deck has its own door
+		double closed = now;
+		for (int deck = 0; deck < cfg.decks; deck++)
+		{
+			int floor = c.floor + deck;
+			if (floor >= 0 && floor < cfg.floors)
+			{
+				unloadPassengers(c, deck);
+				loadPassengers(c, deck);
+				if (c.doors[deck].active)
+				{
+					closed = std::max(closed, c.doors[deck].closedAt());
+				}
+			}
+		}
+		if (closed > now)
+		{
+			// Stay until the doors are closed; late passengers can still board
+			c.dwelling = true;
+			c.readyAt = closed;
+			return;
+		}
+	}
+	c.dwelling = false;
+	c.doors.fill({});
+
+	if (cfg.controller)
+	{
+		// 3. The controller decides at its next tick, together with the other cars due then
+		c.awaitingCommand = true;
+		c.readyAt = cfg.controllerTick > 0.0 ? std::max(now, std::ceil(now / cfg.controllerTick) * cfg.controllerTick) : now;
+		return;
+	}
+
+	// 3. Decide direction and 4. move the car
+	int fromFloor = c.floor;
+	updateDirection(c);
+	departCar(c, fromFloor);
+}
+
+void ElevatorEngine::departCar(car& c, int fromFloor)
+{
+	if (c.floor != fromFloor)
+	{
+		moveCar(c);
+	}
+	else
+	{
+		c.readyAt = now + IDLE_POLL_TIME;
+	}
+}
+
+// Tick 0: sends the building state to the external controller on its own and applies
+// its commands to every car waiting for one at this time
+void ElevatorEngine::commandCars()
+{
+	fillControllerState();
+	commands.clear();
+	const controllerState* state = &controlState;
+	bool answered = cfg.controller->decide({ &state, 1 }, commands);
+	applyCommands(commands, !answered);
+}
+
+const controllerState* ElevatorEngine::pendingDecision()
+{
+	if (!ticked())
+	{
+		return nullptr;
+	}
+	for (const auto& c : cars)
+	{
+		if (c.awaitingCommand && c.readyAt <= now)
+		{
+			fillControllerState();
+			return &controlState;
+		}
+	}
+	return nullptr;
+}
+
+void ElevatorEngine::applyCommands(std::span<const carCommand> given, bool controllerGone)
+{
+	if (controllerGone)
+	{
+		cfg.controller = nullptr; // The built-in rule takes over
+		given = {};
+	}
+	for (auto& c : cars)
+	{
+		if (!c.awaitingCommand || c.readyAt > now)
+		{
+			continue;
+		}
+		c.awaitingCommand = false;
+		auto command = std::find_if(given.begin(), given.end(), [&](const carCommand& k) { return k.car == c.id; });
+		int fromFloor = c.floor;
+		if (command != given.end())
+		{
+			applyCommand(c, *command);
+		}
+		else
+		{
+			updateDirection(c);
+		}
+		departCar(c, fromFloor);
+	}
+}
+
+void ElevatorEngine::fillControllerState()
+{
+	controllerState& s = controlState;
+	uint64_t tick = cfg.controllerTick > 0.0 ? static_cast<uint64_t>(std::llround(now / cfg.controllerTick)) : lastTick + 1;
+	s.building = cfg.buildingId;
+	s.tick = tick;
+	s.ticksElapsed = static_cast<uint32_t>(tick - lastTick);
+	s.time = now;
+	lastTick = tick;
+
+	s.waitingUp.resize(cfg.floors);
+	s.waitingDown.resize(cfg.floors);
+	for (int i = 0; i < cfg.floors; i++)
+	{
+		s.waitingUp[i] = floorPassengers[i].hasDirection(true);
+		s.waitingDown[i] = floorPassengers[i].hasDirection(false);
+	}
+	s.cars.clear();
+	s.stops.assign(static_cast<size_t>(cfg.cars) * cfg.decks * cfg.floors, 0);
+	for (auto& c : cars)
+	{
+		s.cars.push_back({ c.floor, static_cast<int>(c.passengers.size()), c.goingUp,
+			c.awaitingCommand && c.readyAt <= now, c.dwelling });
+		for (auto* p : c.passengers)
+		{
+			s.stops[(static_cast<size_t>(c.id) * cfg.decks + p->deck) * cfg.floors + p->destination] = 1;
+		}
+	}
+}
+
+void ElevatorEngine::applyCommand(car& c, const carCommand& command)
+{
+	// Idle as the built-in rule sees it, so the sibling makes way under the same conditions
+	bool idle = c.passengers.empty() && !isDestinationAbove(c) && !isDestinationBelow(c);
+	if (!idle)
+	{
+		c.idleSince = -1.0;
+	}
+	else if (c.idleSince < 0.0)
+	{
+		c.idleSince = now;
+	}
+	c.goingUp = command.goingUp;
+	int step = avoidCollision(c, std::clamp(command.step, -1, 1), idle);
+	if (c.floor + step < c.minFloor || c.floor + step > c.maxFloor)
+	{
+		step = 0;
+	}
+	c.floor += step;
+	clampDirection(c.goingUp, c.floor - c.minFloor, c.maxFloor - c.minFloor + 1);
+}
+
+void ElevatorEngine::unloadPassengers(car& c, int deck)
+{
+	int floor = c.floor + deck;
+	size_t leaving = 0;
+	for (size_t i = c.passengers.size(); i-- > 0;)
+	{
+		passenger* p = c.passengers[i];
+		if (p->deck == deck && p->destination == floor)
+		{
+			c.doors[deck].transfer(now, c.deckLoad[deck]--, cfg.capacity);
+			p->alightTime = now;
+			if (cfg.journeyLog)
+			{
+				cfg.journeyLog->append({ p->passengerId, cfg.buildingId, static_cast<int16_t>(c.id),
+					static_cast<int16_t>(p->startFloor), static_cast<int16_t>(p->destination),
+					p->arrivalTime, p->boardTime, p->alightTime });
+			}
+			c.passengers.erase(c.passengers.begin() + i);
+			allocator.delete_object(p);
+			++leaving;
+		}
+	}
+	stats.delivered += leaving;
+}
+
+void ElevatorEngine::loadPassengers(car& c, int deck)
+{
+	auto& queue = floorPassengers[c.floor + deck];
+	size_t freeSpace = cfg.capacity > c.deckLoad[deck] ? cfg.capacity - c.deckLoad[deck] : 0;
+	double waitedBefore = queue.servedWait();
+	boardedScratch.clear();
+	queue.popDirection(c.goingUp, freeSpace, now, boardedScratch);
+	for (auto* p : boardedScratch)
+	{
+		board(c, deck, p);
+	}
+	stats.totalWait += queue.servedWait() - waitedBefore;
+}
+
+void ElevatorEngine::board(car& c, int deck, passenger* p)
+{
+	c.doors[deck].transfer(now, c.deckLoad[deck]++, cfg.capacity);
+	p->isInElevator = true;
+	p->boardTime = now;
+	p->carId = c.id;
+	p->deck = deck;
+	recordWait(stats, now - p->arrivalTime);
+	c.passengers.push_back(p);
+	++stats.boarded;
+}
+
+void ElevatorEngine::updateDirection(car& c)
+{
+	bool idle = false;
+	int step = decideStep(c.goingUp, isDestinationAbove(c), isDestinationBelow(c), c.passengers.empty(), idle);
+	if (idle)
+	{
+		if (c.idleSince < 0.0)
+		{
+			c.idleSince = now;
+		}
+		step = idleStep(c.goingUp, c.floor, now - c.idleSince, cfg.dispatch,
+			std::clamp(parkingFloor(c), lowestReachable(c), highestReachable(c)));
+	}
+	else
+	{
+		c.idleSince = -1.0;
+	}
+	step = avoidCollision(c, step, idle);
+	c.floor += step;
+	clampDirection(c.goingUp, c.floor - c.minFloor, c.maxFloor - c.minFloor + 1);
+}
+
+// Where an idle car waits for the next call: the ground floor, unless the demand model
+// expects calls elsewhere in the coming minutes. The idle cars then spread over the
+// busiest origins: origins are taken busiest first, each by the nearest idle car not
+// placed yet, and idle cars left over (more than DEMAND_TOP_ORIGINS, or more than the
+// floors still expecting calls) stay where they are.
+int ElevatorEngine::parkingFloor(const car& c)
+{
+	if (demand.empty())
+	{
+		return 0;
+	}
+	idleScratch.clear();
+	for (const car& other : cars)
+	{
+		if (other.idleSince >= 0.0 && other.passengers.empty())
+		{
+			idleScratch.push_back(other.id);
+		}
+	}
+	demand.busiestOrigins(now + DEMAND_LOOKAHEAD, static_cast<int>(idleScratch.size()), parkingScratch);
+	if (parkingScratch.empty())
+	{
+		return 0;
+	}
+	for (int origin : parkingScratch)
+	{
+		auto nearest = std::min_element(idleScratch.begin(), idleScratch.end(), [&](int a, int b)
+			{
+				return std::abs(cars[a].floor - origin) < std::abs(cars[b].floor - origin);
+			});
+		if (*nearest == c.id)
+		{
+			return origin;
+		}
+		idleScratch.erase(nearest);
+	}
+	return c.floor;
+}
+
+// Keeps the cars of a shared shaft apart. Returns the step the car may take.
+int ElevatorEngine::avoidCollision(car& c, int step, bool idle)
+{
+	if (c.sibling < 0)
+	{
+		return step;
+	}
+	car& other = cars[c.sibling];
+	int away = c.upper ? 1 : -1;
+	if (c.makeWay)
+	{
+		// The sibling carries passengers towards this car: never move towards it, step away when in the way
+		bool inTheWay = std::abs(c.floor - other.floor) == cfg.decks;
+		if (step == -away || (step == 0 && inTheWay))
+		{
+			step = inTheWay && c.floor + away >= c.minFloor && c.floor + away <= c.maxFloor ? away : 0;
+		}
+		if (step != 0)
+		{
+			c.goingUp = step > 0;
+		}
+		return step;
+	}
+	// Passengers to deliver towards the sibling: it has to make way until they are delivered
+	other.makeWay = step == -away && !idle;
+	if (step != 0 && std::abs(c.floor + step - other.floor) < cfg.decks)
+	{
+		return 0; // Blocked, wait for the sibling to move
+	}
+	return step;
+}
+
+int ElevatorEngine::lowestReachable(const car& c) const
+{
+	return c.sibling >= 0 && c.upper ? cars[c.sibling].floor + cfg.decks : c.minFloor;
+}
+
+int ElevatorEngine::highestReachable(const car& c) const
+{
+	return c.sibling >= 0 && !c.upper ? cars[c.sibling].floor - cfg.decks : c.maxFloor;
+}
+
+// True if one of the decks is at the given floor for some car position in [from, to]
+bool ElevatorEngine::reachesFloor(int floor, int from, int to) const
+{
+	return floor >= from && floor - (cfg.decks - 1) <= to;
+}
+
+void ElevatorEngine::moveCar(car& c)
+{
+	c.readyAt = now + FLOOR_TRAVEL_TIME;
+	stats.energy += ENERGY_PER_FLOOR + ENERGY_PER_PASSENGER_FLOOR * static_cast<double>(c.passengers.size());
+	++stats.floorsTravelled;
+}
+
+bool ElevatorEngine::isDestinationAbove(const car& c) const
+{
+	if (acceptsCalls(static_cast<int>(c.passengers.size()), cfg.capacity * cfg.decks, cfg.dispatch))
+	{
+		int highest = highestReachable(c);
+		for (int i = cfg.floors - 1; i > c.floor && i >= 0; i--) // A car in the pit is below floor 0
+		{
+			if (!floorPassengers[i].empty() && reachesFloor(i, c.floor + 1, highest))
+			{
+				return true;
+			}
+		}
+	}
+	for (auto* p : c.passengers)
+	{
+		if (p->destination - p->deck > c.floor)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ElevatorEngine::isDestinationBelow(const car& c) const
+{
+	if (acceptsCalls(static_cast<int>(c.passengers.size()), cfg.capacity * cfg.decks, cfg.dispatch))
+	{
+		int lowest = lowestReachable(c);
+		for (int i = std::max(0, lowest); i < c.floor + cfg.decks - 1 && i < cfg.floors; i++)
+		{
+			if (!floorPassengers[i].empty() && reachesFloor(i, lowest, c.floor - 1))
+			{
+				return true;
+			}
+		}
+	}
+	for (auto* p : c.passengers)
+	{
+		if (p->destination - p->deck < c.floor)
+		{
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <memory_resource>
+#include "Building.h"
+#include "DemandModel.h"
+#include "DispatchController.h"
+#include "FloorQueue.h"
+#include "Traffic.h"
+
+// Headless version of ElevatorLogic: the same unload/load/direction/move cycle,
+// driven by simulated time instead of sprite animations. Works for any number of floors,
+// cars and capacity; see BasicElevatorEngine for the specialised small configurations.
+//
+// A car may have up to MAX_DECKS decks that stop at adjacent floors together, and up to
+// MAX_CARS_PER_SHAFT cars may share a shaft. A car's position is the floor of its lowest
+// deck. Shafts extend below the ground floor and above the top floor (pit and overrun),
+// far enough that every deck of every car can reach every floor. Cars in one shaft keep
+// at least one car height apart: a car carrying passengers towards its sibling makes the
+// sibling give way, and the sibling never moves towards it until the way is clear.
+//
+// With an external controller, a car ready to depart waits for the next controller tick;
+// the controller then picks the step and direction of all cars due at that tick at once.
+// With tick 0 the engine asks the controller itself; with a longer tick it leaves the
+// waiting cars to Campus, which asks once for all buildings due at the tick. Collision
+// avoidance and the shaft limits still apply to the commands.
+
+class ElevatorEngine final : public BuildingSimulation
+{
+public:
+	ElevatorEngine(const buildingConfig& config_, std::pmr::memory_resource* memory_ = std::pmr::get_default_resource());
+	~ElevatorEngine();
+
+	ElevatorEngine(const ElevatorEngine&) = delete;
+	ElevatorEngine& operator=(const ElevatorEngine&) = delete;
+
+	void advanceTo(double endTime) override;
+	double time() const override { return now; }
+	const buildingMetrics& metrics() const override { return stats; }
+	const buildingConfig& config() const override { return cfg; }
+	void view(buildingView& out) const override;
+	void addUnserved(buildingMetrics& metrics) const override;
+	const controllerState* pendingDecision() override;
+	void applyCommands(std::span<const carCommand> commands, bool controllerGone) override;
+
+private:
+	struct car
+	{
+		explicit car(std::pmr::memory_resource* memory) : passengers(memory) {}
+
+		int id = 0;
+		int floor = 0; // Position of the lowest deck, may be in the pit or overrun of the shaft
+		int minFloor = 0; // Lowest and highest position in the shaft
+		int maxFloor = 0;
+		int sibling = -1; // Other car in the same shaft, -1 if none
+		bool upper = false; // This is the upper car of its shaft
+		bool makeWay = false; // Set while the sibling carries passengers towards this car
+		bool goingUp = true;
+		bool dwelling = false; // Stopped with the doors open or closing; readyAt is when they are closed
+		bool awaitingCommand = false; // Waits for the external controller; readyAt is the tick
+		double readyAt = 0.0; // Time at which the car finishes its current stop or move
+		double idleSince = -1.0; // Time at which the car became empty with no calls, -1 if busy
+		std::array<int, MAX_DECKS> deckLoad{};
+		std::array<doorCycle, MAX_DECKS> doors{};
+		std::pmr::vector<passenger*> passengers;
+	};
+
+	buildingConfig cfg;
+	std::pmr::memory_resource* memory;
+	std::pmr::polymorphic_allocator<passenger> allocator;
+	TrafficGenerator traffic;
+	DemandModel demand; // Empty unless cfg.learnDemand
+	std::pmr::vector<FloorQueue> floorPassengers; // passengers on each floor
+	std::pmr::vector<car> cars;
+	std::vector<passenger*> boardedScratch; // reused buffer for FloorQueue::popDirection
+	std::vector<int> parkingScratch; // reused buffers for parkingFloor
+	std::vector<int> idleScratch;
+	buildingMetrics stats;
+	controllerState controlState; // Reused buffers for the external controller
+	std::vector<carCommand> commands;
+	uint64_t lastTick = 0;
+	double now = 0.0;
+	size_t nextPassengerId = 0;
+
+	void spawnPassenger();
+	bool boardStandingCar(passenger* p);
+	void serveCar(car& c);
+	void unloadPassengers(car& c, int deck);
+	void loadPassengers(car& c, int deck);
+	void board(car& c, int deck, passenger* p);
+	void updateDirection(car& c);
+	int parkingFloor(const car& c);
+	bool ticked() const { return cfg.controller && cfg.controllerTick > 0.0; }
+	void commandCars();
+	void fillControllerState();
+	void applyCommand(car& c, const carCommand& command);
+	void departCar(car& c, int fromFloor);
+	int avoidCollision(car& c, int step, bool idle);
+	int lowestReachable(const car& c) const;
+	int highestReachable(const car& c) const;
+	bool reachesFloor(int floor, int from, int to) const;
+	void moveCar(car& c);
+	bool isDestinationAbove(const car& c) const;
+	bool isDestinationBelow(const car& c) const;
+};
@@ -2,23 +2,32 @@
 
 ElevatorLogic::ElevatorLogic(GdiplusWindow* window_) : window(window_), currentFloor(0), goingUp(false)
 {
-	// Initialize the floorPassengers vector with 5 floors
-	floorPassengers.resize(5);
-	for (int i = 0; i < 5; i++)
+	// Initialize an empty queue for every floor
+	floorPassengers.reserve(FLOOR_COUNT);
+	for (int i = 0; i < FLOOR_COUNT; i++)
 	{
-		floorPassengers[i].clear(); // Ensure each floor starts with no passengers
+		floorPassengers.emplace_back(i, FLOOR_COUNT);
 	}
+	time_t now = time(nullptr);
+	tm local;
+	localtime_s(&local, &now);
+	startTimeOfDay = local.tm_hour * 3600.0 + local.tm_min * 60.0 + local.tm_sec;
 	elevatorData = new elevator(window->AddSprite(L".\\zdjencia\\winda.png", ELEVATOR_START_X, FLOOR_EXITS[0].Y + ELEVATOR_Y_OFFSET));
 	textId = window->AddText(L"Waga pasaerw: 0kg", textPosition.X, textPosition.Y, L"Arial", 16, Gdiplus::Color(255, 0, 0, 0));
 }
 
 bool ElevatorLogic::elevatorLoop(time_t timeSinceStop, bool wasEmpty)
 {
+	TRACE_SCOPE_VALUE("elevatorLoop", currentFloor);
+	// 0. Pick up calls submitted since the last loop
+	drainCalls();
+
 	// 1. Unload passengers whose destination is the current floor
 	unloadPassengersAtCurrentFloor();
 
-	// 2. Load passengers from the current floor
+	// 2. Load passengers from the current floor and keep the door open for the dwell time
 	loadPassengersAtCurrentFloor();
+	holdDoors();
 
 	// 3. Decide elevator direction
 	wasEmpty = updateDirection(timeSinceStop, wasEmpty);
@@ -33,6 +42,7 @@ bool ElevatorLogic::elevatorLoop(time_t timeSinceStop, bool wasEmpty)
 }
 void ElevatorLogic::unloadPassengersAtCurrentFloor()
 {
+	TRACE_SCOPE_VALUE("unload", currentFloor);
 	std::vector<passenger*> leavingPassengers;
 
 	// 1. Mark passengers to leave and animate them directly to off-screen position
@@ -41,6 +51,7 @@ void ElevatorLogic::unloadPassengersAtCurrentFloor()
 		auto* p = passengersInElevator[i];
 		if (p->destination == currentFloor)
 		{
+			door.transfer(simulationTime(), static_cast<int>(passengersInElevator.size()), MAX_CAPACITY);
 			p->isInElevator = false;
 			leavingPassengers.push_back(p);
 			// Animate directly to off-screen position
@@ -50,95 +61,88 @@ void ElevatorLogic::unloadPassengersAtCurrentFloor()
 				FLOOR_EXITS[currentFloor].Y,
 				ANIMATION_SPEED_PX_PER_SEC, true); // true: delete after animation
 			passengersInElevator.erase(passengersInElevator.begin() + i);
-			window->EditText(textId, L"Waga pasaerw: " + std::to_wstring(passengersInElevator.size() * 70) + L"kg", textPosition.X, textPosition.Y, L"Arial", 16, Gdiplus::Color(255, 0, 0, 0));
+			window->EditText(textId, L"Waga pasaerw: " + std::to_wstring(passengersInElevator.size() * PASSENGER_WEIGHT) + L"kg", textPosition.X, textPosition.Y, L"Arial", 16, Gdiplus::Color(255, 0, 0, 0));
 		}
 	}
 
-	// 2. Wait for all leaving passengers to cross the floor exit (just outside elevator)
-	for (auto* p : leavingPassengers)
+	// 2. Reposition remaining elevator passengers; the dwell time does not depend on the animations
+	if (!leavingPassengers.empty())
 	{
-		// Wait until the sprite's X position is past the floor exit (just outside elevator)
-		int exitX = (currentFloor % 2 == 0) ? 253 : 500;
-		// Wait until the sprite's X is less than exitX (left) or greater than exitX (right)
-		while (true)
+		for (size_t i = 0; i < passengersInElevator.size(); ++i)
 		{
-			int spriteX = window->getSpriteX(p->passengerId);
-			if ((currentFloor % 2 == 0 && spriteX <= exitX) ||
-				(currentFloor % 2 != 0 && spriteX >= exitX))
-			{
-				break;
-			}
-			window->WaitForDuration(10); // Small delay to avoid busy waiting
+			window->AnimateSprite(passengersInElevator[i]->passengerId,
+				ELEVATOR_START_X + SPACING * static_cast<int>(i),
+				FLOOR_EXITS[currentFloor].Y,
+				ANIMATION_SPEED_PX_PER_SEC, false);
 		}
 	}
-
-	// 3. Reposition remaining elevator passengers
-	for (size_t i = 0; i < passengersInElevator.size(); ++i)
-	{
-		window->AnimateSprite(passengersInElevator[i]->passengerId,
-			ELEVATOR_START_X + SPACING * static_cast<int>(i),
-			FLOOR_EXITS[currentFloor].Y,
-			ANIMATION_SPEED_PX_PER_SEC, false);
-	}
-
-	// 4. Wait for the last animation of repositioning (if any)
-	if (!passengersInElevator.empty())
-	{
-		window->WaitForSpriteAnimation(passengersInElevator.back()->passengerId);
-	}
 }
 
 void ElevatorLogic::loadPassengersAtCurrentFloor()
 {
+	TRACE_SCOPE_VALUE("load", currentFloor);
 	auto& queue = floorPassengers[currentFloor];
-	bool upward = goingUp;
-	size_t idx = 0;
+	size_t freeSpace = MAX_CAPACITY > passengersInElevator.size() ? MAX_CAPACITY - passengersInElevator.size() : 0;
 	std::vector<passenger*> loadedThisTurn;
-	while (idx < queue.size() && passengersInElevator.size() < MAX_CAPACITY)
+	size_t boarded = queue.popDirection(goingUp, freeSpace, simulationTime(), loadedThisTurn);
+	waitingCount[currentFloor].fetch_sub(static_cast<int>(boarded), std::memory_order_relaxed);
+	// Passengers are boarded oldest first, so the first of them held the frontmost freed slot
+	size_t firstBoardedId = loadedThisTurn.empty() ? 0 : loadedThisTurn.front()->passengerId;
+	for (auto* p : loadedThisTurn)
 	{
-		auto* p = queue[idx];
-		bool wantsToGo = upward ? (p->destination > currentFloor)
-			: (p->destination < currentFloor);
-		if (wantsToGo)
-		{
-			window->AnimateSprite(p->passengerId,
-				ELEVATOR_START_X + SPACING * static_cast<int>(passengersInElevator.size()),
-				FLOOR_EXITS[currentFloor].Y,
-				ANIMATION_SPEED_PX_PER_SEC, false);
-			loadedThisTurn.push_back(p);
-			p->isInElevator = true;
-			passengersInElevator.push_back(p);
-			window->EditText(textId, L"Waga pasaerw: " + std::to_wstring(passengersInElevator.size() * 70) + L"kg", textPosition.X, textPosition.Y, L"Arial", 16, Gdiplus::Color(255, 0, 0, 0));
-			queue.erase(queue.begin() + idx);
-		}
-		else
-		{
-			++idx;
-		}
+		door.transfer(simulationTime(), static_cast<int>(passengersInElevator.size()), MAX_CAPACITY);
+		window->AnimateSprite(p->passengerId,
+			ELEVATOR_START_X + SPACING * static_cast<int>(passengersInElevator.size()),
+			FLOOR_EXITS[currentFloor].Y,
+			ANIMATION_SPEED_PX_PER_SEC, false);
+		p->isInElevator = true;
+		p->queueSlot = -1;
+		passengersInElevator.push_back(p);
 	}
-	// Wait only for the last passenger loaded this turn, if any
 	if (!loadedThisTurn.empty())
 	{
-		window->WaitForSpriteAnimation(loadedThisTurn.back()->passengerId);
+		window->EditText(textId, L"Waga pasaerw: " + std::to_wstring(passengersInElevator.size() * PASSENGER_WEIGHT) + L"kg", textPosition.X, textPosition.Y, L"Arial", 16, Gdiplus::Color(255, 0, 0, 0));
+		repositionFloorQueue(queue, firstBoardedId);
 	}
-	repositionFloorQueue(queue);
 }
 
-void ElevatorLogic::repositionFloorQueue(const std::vector<passenger*>& queue)
+void ElevatorLogic::holdDoors()
 {
-	for (size_t i = 0; i < queue.size(); ++i)
+	TRACE_SCOPE_VALUE("dwell", currentFloor);
+	// Passengers calling the elevator to this floor before the door has closed still board
+	while (door.active && simulationTime() < door.closedAt())
 	{
-		int offset = OFFSET_BASE * static_cast<int>(i);
-		int x = (currentFloor % 2 == 0) ? (LEFT_X - offset) : (RIGHT_X + offset);
-		window->AnimateSprite(queue[i]->passengerId,
-			x,
-			FLOOR_EXITS[currentFloor].Y,
-			ANIMATION_SPEED_PX_PER_SEC, false);
+		window->WaitForDuration(DWELL_POLL_MS);
+		drainCalls();
+		loadPassengersAtCurrentFloor();
 	}
+	door = {};
+}
+
+void ElevatorLogic::repositionFloorQueue(const FloorQueue& queue, size_t firstBoardedId)
+{
+	// Passengers ahead of the first boarded one keep their place, so the walk starts behind it.
+	// Everyone behind it moves up and has to be animated, which the walk cannot avoid.
+	int slot = static_cast<int>(queue.countBefore(firstBoardedId));
+	queue.forEachFrom(firstBoardedId, [&](passenger* p)
+		{
+			if (p->queueSlot != slot)
+			{
+				p->queueSlot = slot;
+				int offset = OFFSET_BASE * slot;
+				int x = (currentFloor % 2 == 0) ? (LEFT_X - offset) : (RIGHT_X + offset);
+				window->AnimateSprite(p->passengerId,
+					x,
+					FLOOR_EXITS[currentFloor].Y,
+					ANIMATION_SPEED_PX_PER_SEC, false);
+			}
+			++slot;
+		});
 }
 
 bool ElevatorLogic::updateDirection(time_t timeSinceStop, bool wasEmpty)
 {
+	TRACE_SCOPE_VALUE("direction", currentFloor);
 	bool hasAbove = isDestinationAbove(currentFloor);
 	bool hasBelow = isDestinationBelow(currentFloor);
 	bool empty = passengersInElevator.empty();
@@ -194,11 +198,13 @@ bool ElevatorLogic::updateDirection(time_t timeSinceStop, bool wasEmpty)
 
 void ElevatorLogic::handleIdleBehavior(time_t timeSinceStop)
 {
-	if (timeSinceStop >= IDLE_THRESHOLD && currentFloor > 0)
+	// Floor where calls are expected soon, the ground floor until the demand model knows better
+	int parkingFloor = demand.busiestOrigin(timeOfDay() + DEMAND_LOOKAHEAD, 0);
+	if (timeSinceStop >= IDLE_THRESHOLD && currentFloor != parkingFloor)
 	{
-		// Return to ground floor after idle time
-		goingUp = false;
-		--currentFloor;
+		// Go to the parking floor after idle time
+		goingUp = parkingFloor > currentFloor;
+		currentFloor += goingUp ? 1 : -1;
 	}
 	else if (timeSinceStop < IDLE_THRESHOLD)
 	{
@@ -209,6 +215,7 @@ void ElevatorLogic::handleIdleBehavior(time_t timeSinceStop)
 
 void ElevatorLogic::animatePassengersInElevator()
 {
+	TRACE_SCOPE("animate");
 	for (size_t i = 0; i < passengersInElevator.size(); ++i)
 	{
 		window->AnimateSprite(passengersInElevator[i]->passengerId,
@@ -220,6 +227,7 @@ void ElevatorLogic::animatePassengersInElevator()
 
 void ElevatorLogic::moveElevatorSprite()
 {
+	TRACE_SCOPE_VALUE("move", currentFloor);
 	window->AnimateSprite(elevatorData->elevatorId,
 		ELEVATOR_START_X,
 		FLOOR_EXITS[currentFloor].Y + ELEVATOR_Y_OFFSET,
@@ -229,20 +237,60 @@ void ElevatorLogic::moveElevatorSprite()
 
 
 
-void ElevatorLogic::addPassenger(int startFloor, int destination, size_t spriteId)
+bool ElevatorLogic::submitCall(int startFloor, int destination, size_t spriteId)
 {
-	if (startFloor < 0 || startFloor > 4 || destination < 0 || destination > 4 || startFloor == destination)
+	if (startFloor < 0 || startFloor >= FLOOR_COUNT || destination < 0 || destination >= FLOOR_COUNT || startFloor == destination)
+	{
+		return false; // Invalid floor or destination
+	}
+	waitingCount[startFloor].fetch_add(1, std::memory_order_relaxed);
+	if (!calls.push({ startFloor, destination, spriteId }))
 	{
-		exit(EXIT_FAILURE); // Invalid floor or destination
+		waitingCount[startFloor].fetch_sub(1, std::memory_order_relaxed);
+		return false;
 	}
-	floorPassengers[startFloor].push_back(new passenger(startFloor, destination, false, spriteId));
+	return true;
+}
+
+void ElevatorLogic::drainCalls()
+{
+	calls.drain([this](const callRequest& call)
+		{
+			addPassenger(call.startFloor, call.destination, call.spriteId);
+		});
+}
+
+void ElevatorLogic::addPassenger(int startFloor, int destination, size_t spriteId)
+{
+	auto& queue = floorPassengers[startFloor];
+	auto* p = new passenger(startFloor, destination, false, spriteId, simulationTime());
+	queue.push(p);
+	// A new passenger is the youngest on the floor, so their place is at the end of the queue.
+	// Placing them now means boarding never has to look at the passengers ahead of it.
+	p->queueSlot = static_cast<int>(queue.size()) - 1;
+	int offset = OFFSET_BASE * p->queueSlot;
+	window->AnimateSprite(spriteId,
+		(startFloor % 2 == 0) ? (LEFT_X - offset) : (RIGHT_X + offset),
+		FLOOR_EXITS[startFloor].Y,
+		ANIMATION_SPEED_PX_PER_SEC, false);
+	demand.observe(timeOfDay(), startFloor, destination);
+}
+
+double ElevatorLogic::simulationTime() const
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+double ElevatorLogic::timeOfDay() const
+{
+	return startTimeOfDay + simulationTime();
 }
 
 bool ElevatorLogic::isDestinationAbove(int floor)
 {
 	for (int i = floorPassengers.size() - 1; i > floor; i--)
 	{
-		if (!floorPassengers[i].empty() && passengersInElevator.size() < 7)
+		if (!floorPassengers[i].empty() && passengersInElevator.size() + CALL_RESERVE < MAX_CAPACITY)
 		{
 			return true;
 		}
@@ -261,7 +309,7 @@ bool ElevatorLogic::isDestinationBelow(int floor)
 {
 	for (int i = 0; i < floor; i++)
 	{
-		if (!floorPassengers[i].empty() && passengersInElevator.size() < 7)
+		if (!floorPassengers[i].empty() && passengersInElevator.size() + CALL_RESERVE < MAX_CAPACITY)
 		{
 			return true;
 		}
@@ -5,23 +5,17 @@
 #include <time.h>
 #include <queue>
 #include <algorithm>
+#include <atomic>
+#include "FloorQueue.h"
+#include "CallQueue.h"
+#include "DemandModel.h"
+#include "Dwell.h"
+#include "Trace.h"
 
-constexpr int MAX_CAPACITY = 8; // Maximum number of passengers in the elevator
-constexpr int SPACING = 24; // Spacing between passengers in the elevator
-constexpr int OFFSET_BASE = 24; // Base offset for repositioning passengers on the floor
-constexpr int LEFT_X = 253; // X position for left side of the floor
-constexpr int RIGHT_X = 500; // X position for right side of the floor
 constexpr int ANIMATION_SPEED_PX_PER_SEC = 100; // Speed of passenger animations in pixels per second
 constexpr int ANIMATION_DELAY_MS = 1; // Delay after moving the elevator sprite
-constexpr int IDLE_THRESHOLD = 5; // Time in seconds after which the elevator returns to ground floor if idle
-
-struct passenger
-{
-	int startFloor;
-	int destination;
-	bool isInElevator = false;
-	size_t passengerId;
-};
+constexpr size_t CALL_QUEUE_SIZE = 256; // Maximum number of calls waiting to be picked up by the simulation
+constexpr int DWELL_POLL_MS = 50; // Interval at which a standing elevator checks for late passengers
 
 struct elevator
 {
@@ -34,24 +28,40 @@ public:
 	ElevatorLogic(GdiplusWindow* window_);
 
 	bool elevatorLoop(time_t timeSinceStop, bool wasEmpty);
-	void addPassenger(int startFloor, int destination, size_t spriteId);
-	int passengerCount(int floor) const { return floorPassengers[floor].size(); }
+	// Thread-safe and lock-free; the call is picked up at the start of the next elevatorLoop.
+	// Returns false if the call is invalid or the call queue is full.
+	bool submitCall(int startFloor, int destination, size_t spriteId);
+	// Includes calls that were submitted but not yet picked up. Thread-safe.
+	int passengerCount(int floor) const { return waitingCount[floor].load(std::memory_order_relaxed); }
+	const FloorQueue& floorQueue(int floor) const { return floorPassengers[floor]; }
+	double simulationTime() const; // Seconds since the simulation started
+	double timeOfDay() const; // Local time of day in seconds, continuing past midnight
 
 private:
 	GdiplusWindow* window; // Pointer to the GUI window for drawing
 	elevator* elevatorData;
-	COORD textPosition = { 300, 25 }; // Position for the text displaying passenger weight
+	COORD textPosition = { WEIGHT_TEXT.X, WEIGHT_TEXT.Y }; // Position for the text displaying passenger weight
 	size_t textId;
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	double startTimeOfDay = 0.0; // Local time of day at startTime, in seconds
 	int currentFloor = 0;
 	bool goingUp = false; // true if elevator is going up, false if going down
 	bool isDestinationAbove(int floor);
 	bool isDestinationBelow(int floor);
-	std::vector<std::vector<passenger*>> floorPassengers; // passengers on each floor
+	std::vector<FloorQueue> floorPassengers; // passengers on each floor
 	std::vector<passenger*> passengersInElevator; // passengers currently in the elevator
+	CallQueue<callRequest, CALL_QUEUE_SIZE> calls; // calls submitted from other threads
+	std::array<std::atomic<int>, FLOOR_COUNT> waitingCount{}; // waiting + submitted passengers on each floor
+	DemandModel demand{ FLOOR_COUNT }; // calls seen so far by time of day, decides where to park
+	doorCycle door; // door timeline of the current stop
+
+	void drainCalls();
+	void addPassenger(int startFloor, int destination, size_t spriteId);
 
 	void loadPassengersAtCurrentFloor();
-	void repositionFloorQueue(const std::vector<passenger*>& queue);
+	void repositionFloorQueue(const FloorQueue& queue, size_t firstBoardedId);
 	void unloadPassengersAtCurrentFloor();
+	void holdDoors();
 	bool updateDirection(time_t timeSinceStop, bool wasEmpty);
 	void handleIdleBehavior(time_t timeSinceStop);
 	void animatePassengersInElevator();
@@ -0,0 +1,61 @@
+#include "FloorQueue.h"
+#include <algorithm>
+
+FloorQueue::FloorQueue(int floor_, int floorCount, std::pmr::memory_resource* memory)
+	: floor(floor_), up(memory), down(memory), destinationCounts(floorCount, 0, memory)
+{
+}
+
+void FloorQueue::push(passenger* p)
+{
+	if (p->destination > floor)
+	{
+		up.push_back(p);
+	}
+	else
+	{
+		down.push_back(p);
+	}
+	++destinationCounts[p->destination];
+	arrivalSum += p->arrivalTime;
+}
+
+size_t FloorQueue::popDirection(bool upward, size_t maxCount, double now, std::vector<passenger*>& boarded)
+{
+	auto& queue = upward ? up : down;
+	size_t count = 0;
+	while (count < maxCount && !queue.empty())
+	{
+		passenger* p = queue.front();
+		queue.pop_front();
+		--destinationCounts[p->destination];
+		arrivalSum -= p->arrivalTime;
+		servedWaitSum += now - p->arrivalTime;
+		++served;
+		boarded.push_back(p);
+		++count;
+	}
+	if (empty())
+	{
+		arrivalSum = 0.0; // Drop accumulated floating point error
+	}
+	return count;
+}
+
+double FloorQueue::oldestArrival() const
+{
+	if (up.empty())
+	{
+		return down.empty() ? 0.0 : down.front()->arrivalTime;
+	}
+	if (down.empty())
+	{
+		return up.front()->arrivalTime;
+	}
+	return std::min(up.front()->arrivalTime, down.front()->arrivalTime);
+}
+
+size_t FloorQueue::countBefore(size_t passengerId) const
+{
+	return static_cast<size_t>((firstFrom(up, passengerId) - up.begin()) + (firstFrom(down, passengerId) - down.begin()));
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include <memory_resource>
+#include <utility>
+#include "Simulation.h"
+
+// Passengers waiting on one floor. Upward and downward passengers are kept in
+// separate FIFO queues, so boarding in the current direction only touches the
+// passengers that actually board. Statistics are updated on every push/pop and
+// can be read in O(1).
+class FloorQueue
+{
+public:
+	FloorQueue(int floor_, int floorCount, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+	void push(passenger* p);
+	// Removes up to maxCount passengers travelling in the given direction, oldest first,
+	// and appends them to boarded. Returns the number of removed passengers.
+	size_t popDirection(bool upward, size_t maxCount, double now, std::vector<passenger*>& boarded);
+
+	size_t size() const { return up.size() + down.size(); }
+	bool empty() const { return up.empty() && down.empty(); }
+	bool hasDirection(bool upward) const { return upward ? !up.empty() : !down.empty(); }
+
+	double oldestArrival() const; // Arrival time of the longest waiting passenger (0 if empty)
+	int countFor(int destination) const { return destinationCounts[destination]; }
+	double waitingTime(double now) const { return static_cast<double>(size()) * now - arrivalSum; }
+	double servedWait() const { return servedWaitSum; }
+	double cumulativeWait(double now) const { return servedWaitSum + waitingTime(now); }
+	size_t servedCount() const { return served; }
+
+	// Number of waiting passengers that arrived before passengerId, O(log n)
+	size_t countBefore(size_t passengerId) const;
+
+	// Calls f(passenger*) for every waiting passenger in arrival order (by passengerId).
+	template<typename F>
+	void forEach(F&& f) const
+	{
+		forEachFrom(0, std::forward<F>(f));
+	}
+
+	// Like forEach, but skips the passengers that arrived before passengerId
+	template<typename F>
+	void forEachFrom(size_t passengerId, F&& f) const
+	{
+		auto u = firstFrom(up, passengerId);
+		auto d = firstFrom(down, passengerId);
+		while (u != up.end() || d != down.end())
+		{
+			if (d == down.end() || (u != up.end() && (*u)->passengerId < (*d)->passengerId))
+			{
+				f(*u++);
+			}
+			else
+			{
+				f(*d++);
+			}
+		}
+	}
+
+private:
+	using passengerDeque = std::pmr::deque<passenger*>;
+
+	// Both queues are in arrival order, so the first passenger not older than passengerId
+	// is found by binary search
+	static passengerDeque::const_iterator firstFrom(const passengerDeque& queue, size_t passengerId)
+	{
+		return std::lower_bound(queue.begin(), queue.end(), passengerId,
+			[](const passenger* p, size_t id) { return p->passengerId < id; });
+	}
+
+	int floor;
+	std::pmr::deque<passenger*> up; // passengers with destination above this floor
+	std::pmr::deque<passenger*> down; // passengers with destination below this floor
+	std::pmr::vector<int> destinationCounts;
+	double arrivalSum = 0.0; // Sum of arrival times of waiting passengers
+	double servedWaitSum = 0.0; // Total wait of passengers that already boarded
+	size_t served = 0;
+};
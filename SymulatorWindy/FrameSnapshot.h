@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Immutable picture of everything on screen, published by the simulation thread and
+// drawn by the render thread. Uses only standard types, no Windows headers.
+
+struct frameSprite
+{
+	size_t spriteId;
+	std::wstring imagePath;
+	int x;
+	int y;
+	int width;
+	int height;
+};
+
+struct frameLine
+{
+	int x1, y1, x2, y2;
+	uint32_t argb;
+	float thickness;
+};
+
+struct frameText
+{
+	std::wstring text;
+	int x;
+	int y;
+	std::wstring fontFamily;
+	float fontSize;
+	uint32_t argb;
+};
+
+struct frameSnapshot
+{
+	uint64_t sequence = 0; // Increases with every published frame
+	std::vector<frameSprite> sprites;
+	std::vector<frameLine> lines;
+	std::vector<frameText> texts;
+};
+
+// Lock-free triple buffer for one producer and one consumer. The producer always has a
+// buffer to write to and the consumer always gets the latest complete one, so neither
+// side ever waits for the other and a frame is never read while it is being written.
+template<typename T>
+class TripleBuffer
+{
+public:
+	// Buffer owned by the producer; fill it and call publish()
+	T& writeBuffer() { return buffers[writeIndex]; }
+
+	void publish()
+	{
+		unsigned previous = middle.exchange(writeIndex | FRESH, std::memory_order_acq_rel);
+		writeIndex = previous & INDEX_MASK;
+	}
+
+	// Returns the latest published buffer, or nullptr if nothing was published since the last call
+	const T* acquire()
+	{
+		if ((middle.load(std::memory_order_relaxed) & FRESH) == 0)
+		{
+			return nullptr;
+		}
+		unsigned previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+		readIndex = previous & INDEX_MASK;
+		return &buffers[readIndex];
+	}
+
+	// Buffer last returned by acquire(), owned by the consumer
+	const T& readBuffer() const { return buffers[readIndex]; }
+
+private:
+	static constexpr unsigned INDEX_MASK = 3;
+	static constexpr unsigned FRESH = 4;
+
+	T buffers[3];
+	unsigned writeIndex = 0;
+	unsigned readIndex = 1;
+	alignas(64) std::atomic<unsigned> middle{ 2 };
+};
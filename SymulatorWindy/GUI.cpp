@@ -1,4 +1,5 @@
 #include "GUI.h"
+#include "Trace.h"
 #pragma comment (lib,"Gdiplus.lib")
 
 const wchar_t* GdiplusWindow::CLASS_NAME = L"GdiplusWindowClass";
@@ -18,7 +19,7 @@ void GdiplusWindow::RegisterWindowClass(HINSTANCE hInstance, const wchar_t* clas
 	static bool registered = false;
 	if (registered) return;
 	WNDCLASSW wc{};
-	wc.style = CS_HREDRAW | CS_VREDRAW | CS_OWNDC; // Optional: better painting behavior
+	wc.style = CS_HREDRAW | CS_VREDRAW; // No CS_OWNDC: the render thread gets its own DC
 	wc.lpfnWndProc = StaticWndProc;
 	wc.hInstance = hInstance;
 	wc.lpszClassName = className;
@@ -33,9 +34,10 @@ GdiplusWindow::GdiplusWindow(HINSTANCE hInstance, const std::wstring& windowTitl
 	: hInst_(hInstance) {
 	InitializeGDIPlus();
 	if (!backgroundImagePath.empty()) {
-		background_ = std::make_unique<Gdiplus::Bitmap>(backgroundImagePath.c_str());
-		if (background_->GetLastStatus() != Gdiplus::Ok)
+		Gdiplus::Bitmap background(backgroundImagePath.c_str());
+		if (background.GetLastStatus() != Gdiplus::Ok)
 			throw std::runtime_error("Failed to load background image.");
+		backgroundPath_ = backgroundImagePath;
 	}
 	RegisterWindowClass(hInstance, CLASS_NAME);
 	hWnd_ = CreateWindowExW(0, CLASS_NAME, windowTitle.c_str(),
@@ -43,9 +45,17 @@ GdiplusWindow::GdiplusWindow(HINSTANCE hInstance, const std::wstring& windowTitl
 		CW_USEDEFAULT, CW_USEDEFAULT, width, height, nullptr, nullptr, hInstance, this);
 	if (!hWnd_)
 		throw std::runtime_error("Failed to create window.");
+	rendering_ = true;
+	renderThread_ = std::thread(&GdiplusWindow::RenderLoop, this);
 }
 
-GdiplusWindow::~GdiplusWindow() { ShutdownGDIPlus(); }
+GdiplusWindow::~GdiplusWindow() {
+	rendering_ = false;
+	renderRequests_.fetch_add(1);
+	renderRequests_.notify_one();
+	if (renderThread_.joinable()) renderThread_.join();
+	ShutdownGDIPlus();
+}
 
 void GdiplusWindow::Show(int nCmdShow) {
 	ShowWindow(hWnd_, nCmdShow);
@@ -67,18 +77,16 @@ int GdiplusWindow::RunMessageLoop() {
 }
 
 GdiplusWindow::SpriteId GdiplusWindow::AddSprite(const std::wstring& imagePath, int x, int y) {
-	auto img = std::make_unique<Gdiplus::Bitmap>(imagePath.c_str());
-	if (img->GetLastStatus() != Gdiplus::Ok) return (SpriteId)-1;
- 
-	Sprite s{
-		nextSpriteId_++,
-		std::move(img),
-		Gdiplus::Point(x, y),
-		Gdiplus::Size((INT)s.image->GetWidth(), (INT)s.image->GetHeight())
-	};
-
-	sprites_.push_back(std::move(s));
-	InvalidateRect(hWnd_, nullptr, FALSE);
+	auto size = imageSizes_.find(imagePath);
+	if (size == imageSizes_.end()) {
+		// The image is only loaded here to check it and read its size; the render thread keeps its own copy
+		Gdiplus::Bitmap img(imagePath.c_str());
+		if (img.GetLastStatus() != Gdiplus::Ok) return (SpriteId)-1;
+		size = imageSizes_.emplace(imagePath, Gdiplus::Size((INT)img.GetWidth(), (INT)img.GetHeight())).first;
+	}
+
+	sprites_.push_back({ nextSpriteId_++, imagePath, Gdiplus::Point(x, y), size->second });
+	frameDirty_ = true;
 	return sprites_.back().id;
 }
 
@@ -101,25 +109,25 @@ void GdiplusWindow::RemoveSprite(SpriteId id) {
 	auto it = std::remove_if(sprites_.begin(), sprites_.end(), [id](const Sprite& s) { return s.id == id; });
 	if (it != sprites_.end()) {
 		sprites_.erase(it, sprites_.end());
-		InvalidateRect(hWnd_, nullptr, FALSE);
+		frameDirty_ = true;
 	}
 }
 
 void GdiplusWindow::MoveSprite(SpriteId id, int newX, int newY) {
 	for (auto& s : sprites_) if (s.id == id) { s.pos = { newX, newY }; break; }
-	InvalidateRect(hWnd_, nullptr, FALSE);
+	frameDirty_ = true;
 }
 
 size_t GdiplusWindow::AddLine(int x1, int y1, int x2, int y2, Gdiplus::Color color, float thickness) {
 	lines_.push_back({ {x1, y1}, {x2, y2}, color, thickness });
-	InvalidateRect(hWnd_, nullptr, FALSE);
+	frameDirty_ = true;
 	return lines_.size() - 1;
 }
 
 void GdiplusWindow::RemoveLine(size_t lineIndex) {
 	if (lineIndex < lines_.size()) {
 		lines_.erase(lines_.begin() + lineIndex);
-		InvalidateRect(hWnd_, nullptr, FALSE);
+		frameDirty_ = true;
 	}
 }
 
@@ -132,21 +140,21 @@ void GdiplusWindow::AnimateLine(size_t lineIndex, int toX1, int toY1, int toX2,
 
 size_t GdiplusWindow::AddText(const std::wstring& text, int x, int y, const std::wstring& fontFamily, float fontSize, Gdiplus::Color color) {
 	texts_.push_back({ text, {x, y}, fontFamily, fontSize, color });
-	InvalidateRect(hWnd_, nullptr, FALSE);
+	frameDirty_ = true;
 	return texts_.size() - 1;
 }
 
 void GdiplusWindow::RemoveText(size_t textIndex) {
 	if (textIndex < texts_.size()) {
 		texts_.erase(texts_.begin() + textIndex);
-		InvalidateRect(hWnd_, nullptr, FALSE);
+		frameDirty_ = true;
 	}
 }
 
 void GdiplusWindow::EditText(size_t textIndex, const std::wstring& newText, int newX, int newY, const std::wstring& newFontFamily, float newFontSize, Gdiplus::Color newColor) {
 	if (textIndex < texts_.size()) {
 		texts_[textIndex] = { newText, {newX, newY}, newFontFamily, newFontSize, newColor };
-		InvalidateRect(hWnd_, nullptr, FALSE);
+		frameDirty_ = true;
 	}
 }
 
@@ -170,43 +178,42 @@ void GdiplusWindow::AnimateSprite(SpriteId id, int toX, int toY, float speedPxPe
 	if (durationMs <= 0) {
 		// Move instantly if speed is zero or negative
 		it->pos = { toX, toY };
-		InvalidateRect(hWnd_, nullptr, FALSE);
+		frameDirty_ = true;
 		return;
 	}
 
 	spriteAnimations_[id] = { it->pos, {toX, toY}, durationMs, std::chrono::steady_clock::now(), true };
 	if (!animationTimerId_) StartAnimationTimer();
-	if (deleteAfter) {
-		std::thread([this, id]() {
-			WaitForSpriteAnimation(id);
-			RemoveSprite(id);
-			}).detach();
-	}
+	if (deleteAfter) removeAfterAnimation_.insert(id); // Removed by UpdateSpriteAnimations on this thread
 }
 
 
+void GdiplusWindow::PumpMessages()
+{
+	MSG msg;
+	while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+		TranslateMessage(&msg);
+		DispatchMessage(&msg);
+	}
+	PublishFrame();
+}
+
 void GdiplusWindow::WaitForSpriteAnimation(SpriteId id)
 {
+	TRACE_SCOPE_VALUE("WaitForSpriteAnimation", id);
 	// Always wait until animation finishes, ignoring timeoutMs
 	while (spriteAnimations_.find(id) != spriteAnimations_.end()) {
-		MSG msg;
-		while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
-		}
+		PumpMessages();
 		std::this_thread::sleep_for(std::chrono::milliseconds(10)); // Avoid busy waiting
 	}
 }
 
 void GdiplusWindow::WaitForDuration(int durationMs)
 {
+	TRACE_SCOPE_VALUE("WaitForDuration", durationMs);
 	std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(durationMs);
 	while (std::chrono::steady_clock::now() < endTime) {
-		MSG msg;
-		while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
-		}
+		PumpMessages();
 		std::this_thread::sleep_for(std::chrono::milliseconds(10)); // Avoid busy waiting
 	}
 }
@@ -235,12 +242,7 @@ LRESULT CALLBACK GdiplusWindow::StaticWndProc(HWND hwnd, UINT msg, WPARAM wp, LP
 
 LRESULT GdiplusWindow::WndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
 	switch (msg) {
-	case WM_PAINT: {
-		PAINTSTRUCT ps;
-		OnPaint(BeginPaint(hwnd, &ps));
-		EndPaint(hwnd, &ps);
-		return 0;
-	}
+	case WM_PAINT: OnPaint(); return 0;
 	case WM_ERASEBKGND: return 1;
 	case WM_COMMAND: OnCommand(wp, lp); return 0;
 	case WM_DESTROY: PostQuitMessage(0); return 0;
@@ -251,7 +253,59 @@ LRESULT GdiplusWindow::WndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
 	return DefWindowProcW(hwnd, msg, wp, lp);
 }
 
-void GdiplusWindow::OnPaint(HDC hdc) {
+void GdiplusWindow::OnPaint() {
+	// Drawing happens on the render thread; just validate the window and ask for a redraw
+	PAINTSTRUCT ps;
+	BeginPaint(hWnd_, &ps);
+	EndPaint(hWnd_, &ps);
+	renderRequests_.fetch_add(1);
+	renderRequests_.notify_one();
+}
+
+void GdiplusWindow::PublishFrame() {
+	if (!frameDirty_) return;
+	TRACE_SCOPE("PublishFrame");
+	frameSnapshot& frame = frames_.writeBuffer();
+	frame.sequence = ++frameSequence_;
+	frame.sprites.clear();
+	for (const auto& s : sprites_)
+		frame.sprites.push_back({ s.id, s.imagePath, s.pos.X, s.pos.Y, s.size.Width, s.size.Height });
+	frame.lines.clear();
+	for (const auto& l : lines_)
+		frame.lines.push_back({ l.start.X, l.start.Y, l.end.X, l.end.Y, l.color.GetValue(), l.thickness });
+	frame.texts.clear();
+	for (const auto& t : texts_)
+		frame.texts.push_back({ t.text, t.pos.X, t.pos.Y, t.fontFamily, t.fontSize, t.color.GetValue() });
+	frames_.publish();
+	frameDirty_ = false;
+	renderRequests_.fetch_add(1);
+	renderRequests_.notify_one();
+}
+
+void GdiplusWindow::RenderLoop() {
+	Trace::setThreadName("render");
+	uint64_t seen = 0;
+	while (rendering_) {
+		renderRequests_.wait(seen);
+		seen = renderRequests_.load();
+		if (!rendering_) break;
+		frames_.acquire(); // Switch to the latest frame if there is a new one
+		HDC hdc = GetDC(hWnd_);
+		if (!hdc) continue;
+		DrawFrame(hdc, frames_.readBuffer());
+		ReleaseDC(hWnd_, hdc);
+	}
+	renderImages_.clear(); // Bitmaps must be released before GDI+ shuts down
+}
+
+Gdiplus::Bitmap* GdiplusWindow::RenderImage(const std::wstring& path) {
+	auto it = renderImages_.find(path);
+	if (it == renderImages_.end()) it = renderImages_.emplace(path, std::make_unique<Gdiplus::Bitmap>(path.c_str())).first;
+	return it->second.get();
+}
+
+void GdiplusWindow::DrawFrame(HDC hdc, const frameSnapshot& frame) {
+	TRACE_SCOPE_VALUE("DrawFrame", frame.sequence);
 	RECT rc; GetClientRect(hWnd_, &rc);
 	int w = rc.right - rc.left, h = rc.bottom - rc.top;
 	HDC memDC = CreateCompatibleDC(hdc);
@@ -260,15 +314,17 @@ void GdiplusWindow::OnPaint(HDC hdc) {
 	HBRUSH back = CreateSolidBrush(RGB(255, 255, 255));
 	FillRect(memDC, &rc, back);
 	DeleteObject(back);
-	Gdiplus::Graphics g(memDC);
-	if (background_) g.DrawImage(background_.get(), 0, 0, w, h);
-	for (const auto& s : sprites_) g.DrawImage(s.image.get(), s.pos.X, s.pos.Y, s.size.Width, s.size.Height);
-	for (const auto& l : lines_) { Gdiplus::Pen pen(l.color, l.thickness); g.DrawLine(&pen, l.start, l.end); }
-	for (const auto& t : texts_) {
-		Gdiplus::FontFamily ff(t.fontFamily.c_str());
-		Gdiplus::Font font(&ff, t.fontSize, Gdiplus::FontStyleRegular, Gdiplus::UnitPixel);
-		Gdiplus::SolidBrush brush(t.color);
-		g.DrawString(t.text.c_str(), -1, &font, Gdiplus::PointF((Gdiplus::REAL)t.pos.X, (Gdiplus::REAL)t.pos.Y), &brush);
+	{
+		Gdiplus::Graphics g(memDC);
+		if (!backgroundPath_.empty()) g.DrawImage(RenderImage(backgroundPath_), 0, 0, w, h);
+		for (const auto& s : frame.sprites) g.DrawImage(RenderImage(s.imagePath), s.x, s.y, s.width, s.height);
+		for (const auto& l : frame.lines) { Gdiplus::Pen pen(Gdiplus::Color(l.argb), l.thickness); g.DrawLine(&pen, Gdiplus::Point(l.x1, l.y1), Gdiplus::Point(l.x2, l.y2)); }
+		for (const auto& t : frame.texts) {
+			Gdiplus::FontFamily ff(t.fontFamily.c_str());
+			Gdiplus::Font font(&ff, t.fontSize, Gdiplus::FontStyleRegular, Gdiplus::UnitPixel);
+			Gdiplus::SolidBrush brush(Gdiplus::Color(t.argb));
+			g.DrawString(t.text.c_str(), -1, &font, Gdiplus::PointF((Gdiplus::REAL)t.x, (Gdiplus::REAL)t.y), &brush);
+		}
 	}
 	BitBlt(hdc, 0, 0, w, h, memDC, 0, 0, SRCCOPY);
 	SelectObject(memDC, oldBmp);
@@ -294,7 +350,6 @@ void GdiplusWindow::StopAnimationTimer() {
 
 void GdiplusWindow::OnAnimationTimer() {
 	UpdateSpriteAnimations();
-	InvalidateRect(hWnd_, nullptr, FALSE);
 }
 
 void GdiplusWindow::UpdateSpriteAnimations() {
@@ -303,8 +358,10 @@ void GdiplusWindow::UpdateSpriteAnimations() {
 		auto& anim = it->second;
 		auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - anim.startTime).count();
 		if (elapsed >= anim.durationMs) {
-			for (auto& s : sprites_) if (s.id == it->first) { s.pos = anim.to; break; }
+			SpriteId id = it->first;
+			for (auto& s : sprites_) if (s.id == id) { s.pos = anim.to; break; }
 			it = spriteAnimations_.erase(it);
+			if (removeAfterAnimation_.erase(id)) RemoveSprite(id);
 		}
 		else {
 			float p = (float)elapsed / anim.durationMs;
@@ -314,5 +371,7 @@ void GdiplusWindow::UpdateSpriteAnimations() {
 			for (auto& s : sprites_) if (s.id == it->first) { s.pos = np; break; }
 			++it;
 		}
+		frameDirty_ = true;
 	}
+	PublishFrame();
 }
@@ -13,17 +13,10 @@
 #include <stdexcept>
 #include <objidl.h> // For Gdiplus
 #include <thread>
-
-constexpr std::array<COORD, 5> FLOOR_EXITS =
-{
-    COORD{0, 482},    // GROUND_FLOOR_EXIT
-    COORD{767, 382},  // FIRST_FLOOR_EXIT
-    COORD{0, 302},    // SECOND_FLOOR_EXIT
-    COORD{767, 158},  // THIRD_FLOOR_EXIT
-    COORD{0, 118}     // FOURTH_FLOOR_EXIT
-};
-constexpr int ELEVATOR_START_X = 298;
-constexpr int ELEVATOR_Y_OFFSET = 64; // Offset for the elevator sprite Y position
+#include <atomic>
+#include <unordered_set>
+#include "FrameSnapshot.h"
+#include "SceneLayout.h"
 
 
 class GdiplusWindow {
@@ -38,6 +31,8 @@ public:
 	GdiplusWindow& operator=(const GdiplusWindow&) = delete;
 
 	void Show(int nCmdShow = SW_SHOW);
+	// Copies the current scene into the next frame for the render thread, if anything changed
+	void PublishFrame();
 	int RunMessageLoop();
 
 	SpriteId AddSprite(const std::wstring& imagePath, int x, int y);
@@ -69,7 +64,7 @@ public:
 	// Window procedure and message handlers
 	static LRESULT CALLBACK StaticWndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp);
 	LRESULT WndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp);
-	void OnPaint(HDC hdc);
+	void OnPaint();
 	void OnCommand(WPARAM wParam, LPARAM lParam);
 
 	// Animation timer
@@ -82,7 +77,7 @@ private:
 	struct Sprite 
 	{
 		SpriteId id;
-		std::unique_ptr<Gdiplus::Bitmap> image;
+		std::wstring imagePath;
 		Gdiplus::Point pos;
 		Gdiplus::Size size;
 	};
@@ -132,14 +127,21 @@ private:
 	static void RegisterWindowClass(HINSTANCE hInstance, const wchar_t* className);
 	void InitializeGDIPlus();
 	void ShutdownGDIPlus();
+	void PumpMessages();
+
+	// Render thread: draws the latest published frame, never touches the scene itself
+	void RenderLoop();
+	void DrawFrame(HDC hdc, const frameSnapshot& frame);
+	Gdiplus::Bitmap* RenderImage(const std::wstring& path);
 
 	// Member variables
 	HWND hWnd_ = nullptr;
 	HINSTANCE hInst_ = nullptr;
 	ULONG_PTR gdiplusToken_ = 0;
 
-	std::unique_ptr<Gdiplus::Bitmap> background_;
+	std::wstring backgroundPath_;
 	std::vector<Sprite> sprites_;
+	std::unordered_map<std::wstring, Gdiplus::Size> imageSizes_; // Sizes of images already loaded
 	std::vector<ButtonInfo> buttons_;
 	std::vector<Line> lines_;
 	std::vector<Text> texts_;
@@ -149,6 +151,15 @@ private:
 	UINT_PTR animationTimerId_ = 0;
 
 	std::unordered_map<size_t, LineAnimation> lineAnimations_;
+	std::unordered_set<SpriteId> removeAfterAnimation_;
+
+	TripleBuffer<frameSnapshot> frames_;
+	bool frameDirty_ = true; // Scene changed since the last published frame
+	uint64_t frameSequence_ = 0;
+	std::atomic<uint64_t> renderRequests_{ 0 }; // Bumped on every publish or repaint request
+	std::atomic<bool> rendering_{ false };
+	std::thread renderThread_;
+	std::unordered_map<std::wstring, std::unique_ptr<Gdiplus::Bitmap>> renderImages_; // Used only by the render thread
 
 	static constexpr UINT ANIMATION_TIMER_INTERVAL_MS = 16;
 	static const wchar_t* CLASS_NAME;
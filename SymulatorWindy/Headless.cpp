@@ -0,0 +1,385 @@
+// Headless.cpp : Simulation without a window, for batch runs on any platform.
+//
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include "Campus.h"
+#include "Tuner.h"
+#include "Trace.h"
+#include "JourneyLog.h"
+#include "RemoteController.h"
+#include "Timelapse.h"
+
+namespace
+{
+	void printUsage()
+	{
+		std::cout << "Uzycie: SymulatorWindyHeadless [opcje]\n"
+			<< "  --kampus <n>     liczba budynkow (domyslnie 200)\n"
+			<< "  --watki <n>      liczba watkow roboczych (domyslnie wszystkie rdzenie)\n"
+			<< "  --czas <s>       symulowany czas w sekundach (domyslnie doba)\n"
+			<< "  --epoka <s>      dlugosc epoki w sekundach (domyslnie 60)\n"
+			<< "  --pietra <n>     liczba pieter w budynku (domyslnie 5)\n"
+			<< "  --windy <n>      liczba wind w budynku (domyslnie 1)\n"
+			<< "  --ruch <n>       pasazerow na godzine w budynku (domyslnie 300)\n"
+			<< "  --poklady <n>    poklady kabiny, 1 lub 2 (kabina dwupoziomowa)\n"
+			<< "  --w-szybie <n>   kabiny w jednym szybie, 1 lub 2\n"
+			<< "  --ziarno <n>     ziarno generatora liczb losowych\n"
+			<< "  --wzorzec <nazwa> rowny (domyslnie) lub biuro: szczyty rano, w porze obiadu i wieczorem\n"
+			<< "  --uczenie        ucz sie zapotrzebowania wg pory dnia i parkuj wolne windy tam, gdzie spodziewane sa wezwania\n"
+			<< "  --dziennik <plik> zapisz przejazd kazdego pasazera do pliku kolumnowego\n"
+			<< "  --dziennik-odczyt <plik> wypisz dziennik przejazdow jako CSV zamiast symulacji\n"
+			<< "  --slad <plik>    zapisz slad czasowy w formacie Chrome/Perfetto (tylko kompilacja z SYMULATOR_TRACE)\n"
+			<< "  --dynamiczny     zawsze uzywaj ogolnego silnika (bez specjalizacji dla malych budynkow)\n"
+			<< "  --sterownik <gniazdo> czekaj na zewnetrzny sterownik na gniezdzie Unix i sluchaj jego polecen\n"
+			<< "  --takt <s>       co ile sekund sterownik decyduje (domyslnie 0: gdy tylko winda jest gotowa)\n"
+			<< "Animacja (budynek z okna: 5 pieter, jedna winda):\n"
+			<< "  --klatki <katalog> zapisz klatki PPM co --co sekund zamiast symulacji kampusu; \"-\" wysyla surowe RGBA 800x600 na wyjscie\n"
+			<< "  --co <s>         symulowany czas miedzy klatkami (domyslnie 60)\n"
+			<< "  --zasoby <katalog> katalog z obrazkami okna (domyslnie zdjencia)\n"
+			<< "Strojenie parametrow sterowania:\n"
+			<< "  --strojenie      szukaj najlepszych parametrow zamiast symulacji kampusu\n"
+			<< "  --profil <p:w:r> profil budynku: pietra, windy, pasazerow na godzine (mozna powtarzac)\n"
+			<< "  --kandydaci <n>  liczba losowanych konfiguracji (domyslnie 32)\n"
+			<< "  --proby <n>      symulacji na konfiguracje w pierwszej rundzie (domyslnie 4)\n"
+			<< "  --cel <nazwa>    p95 (domyslnie), srednia lub energia; czas strojenia domyslnie 8 h\n";
+	}
+
+	// Percentiles beyond the wait histogram are only known to exceed what it covers
+	void printWait(std::ostream& out, double seconds)
+	{
+		if (std::isinf(seconds))
+		{
+			out << "> " << WAIT_BINS * WAIT_BIN_WIDTH;
+		}
+		else
+		{
+			out << seconds;
+		}
+	}
+
+	const char* objectiveName(tuningObjective objective)
+	{
+		switch (objective)
+		{
+		case tuningObjective::meanWait: return "Sredni czas oczekiwania [s]";
+		case tuningObjective::energyPerPassenger: return "Energia na pasazera [kWh]";
+		default: return "95. percentyl oczekiwania [s]";
+		}
+	}
+
+	void printCandidate(const tuningCandidate& c)
+	{
+		std::cout << "prog bezczynnosci " << c.dispatch.idleThreshold << " s, rezerwa miejsc " << c.dispatch.callReserve
+			<< ", zawracanie " << (c.dispatch.idleReverse ? "tak" : "nie") << ", pojemnosc " << c.capacity;
+	}
+
+	// Prints a journey log as CSV, one passenger per line
+	bool dumpJourneyLog(const std::string& path)
+	{
+		JourneyLogReader reader(path);
+		if (!reader.isOpen())
+		{
+			std::cerr << reader.error() << "\n";
+			return false;
+		}
+		std::cout << "pasazer,budynek,winda,skad,dokad,przybycie,wejscie,wyjscie\n";
+		std::vector<journeyRecord> records;
+		char line[160];
+		for (size_t i = 0; i < reader.chunkCount(); i++)
+		{
+			if (!reader.readChunk(i, records))
+			{
+				std::cerr << reader.error() << "\n";
+				return false;
+			}
+			for (const auto& r : records)
+			{
+				std::snprintf(line, sizeof(line), "%llu,%u,%d,%d,%d,%.3f,%.3f,%.3f\n",
+					static_cast<unsigned long long>(r.passengerId), r.building, r.car, r.startFloor, r.destination,
+					r.arrivalTime, r.boardTime, r.alightTime);
+				std::cout << line;
+			}
+		}
+		return static_cast<bool>(std::cout);
+	}
+
+	void runTuning(tuningConfig tuning, const std::vector<buildingConfig>& profiles)
+	{
+		for (const auto& profile : profiles)
+		{
+			tuning.building = profile;
+			auto start = std::chrono::steady_clock::now();
+			tuningResult result = Tuner(tuning).run();
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			std::cout << "Profil: " << profile.floors << " pieter, " << profile.cars << " wind, "
+				<< profile.arrivalsPerHour << " pasazerow/h\n  Najlepsze: ";
+			printCandidate(result.best);
+			std::cout << "\n  " << objectiveName(tuning.objective) << ": ";
+			printWait(std::cout, result.best.score);
+			std::cout << " (domyslne parametry: ";
+			printWait(std::cout, result.baseline.score);
+			std::cout << ") w " << result.best.simulations << " symulacjach\n"
+				<< "  Rundy: " << result.rounds << ", symulacje: " << result.simulations
+				<< ", czas obliczen: " << seconds << " s\n";
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	campusConfig config;
+	std::string tracePath;
+	std::string journeyPath;
+	std::string journeyDumpPath;
+	std::string controllerPath;
+	timelapseConfig timelapse;
+	bool durationSet = false;
+	bool tune = false;
+	tuningConfig tuning;
+	std::vector<buildingConfig> profiles;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--pomoc" || arg == "-h")
+		{
+			printUsage();
+			return 0;
+		}
+		if (arg == "--dynamiczny")
+		{
+			config.forceDynamic = true;
+			continue;
+		}
+		if (arg == "--uczenie")
+		{
+			config.building.learnDemand = true;
+			continue;
+		}
+		if (arg == "--strojenie")
+		{
+			tune = true;
+			continue;
+		}
+		if (i + 1 >= argc)
+		{
+			std::cerr << "Brak wartosci dla opcji " << arg << "\n";
+			return EXIT_FAILURE;
+		}
+		const char* value = argv[++i];
+		if (arg == "--kampus") config.buildings = std::atoi(value);
+		else if (arg == "--watki") config.workers = std::atoi(value);
+		else if (arg == "--czas")
+		{
+			config.duration = std::atof(value);
+			durationSet = true;
+		}
+		else if (arg == "--epoka") config.epoch = std::atof(value);
+		else if (arg == "--pietra") config.building.floors = std::atoi(value);
+		else if (arg == "--windy") config.building.cars = std::atoi(value);
+		else if (arg == "--ruch") config.building.arrivalsPerHour = std::atof(value);
+		else if (arg == "--poklady") config.building.decks = std::atoi(value);
+		else if (arg == "--w-szybie") config.building.carsPerShaft = std::atoi(value);
+		else if (arg == "--slad") tracePath = value;
+		else if (arg == "--dziennik") journeyPath = value;
+		else if (arg == "--dziennik-odczyt") journeyDumpPath = value;
+		else if (arg == "--sterownik") controllerPath = value;
+		else if (arg == "--takt") config.building.controllerTick = std::atof(value);
+		else if (arg == "--klatki") timelapse.output = value;
+		else if (arg == "--co") timelapse.interval = std::atof(value);
+		else if (arg == "--zasoby") timelapse.assets = value;
+		else if (arg == "--wzorzec")
+		{
+			std::string name = value;
+			if (name == "rowny") config.building.pattern = trafficPattern::uniform;
+			else if (name == "biuro") config.building.pattern = trafficPattern::officeDay;
+			else
+			{
+				std::cerr << "Nieznany wzorzec ruchu " << name << "\n";
+				return EXIT_FAILURE;
+			}
+		}
+		else if (arg == "--kandydaci") tuning.candidates = std::atoi(value);
+		else if (arg == "--proby") tuning.firstSimulations = std::atoi(value);
+		else if (arg == "--cel")
+		{
+			std::string name = value;
+			if (name == "p95") tuning.objective = tuningObjective::p95Wait;
+			else if (name == "srednia") tuning.objective = tuningObjective::meanWait;
+			else if (name == "energia") tuning.objective = tuningObjective::energyPerPassenger;
+			else
+			{
+				std::cerr << "Nieznany cel strojenia " << name << "\n";
+				return EXIT_FAILURE;
+			}
+		}
+		else if (arg == "--profil")
+		{
+			buildingConfig profile;
+			if (std::sscanf(value, "%d:%d:%lf", &profile.floors, &profile.cars, &profile.arrivalsPerHour) != 3
+				|| profile.floors < 2 || profile.cars < 1)
+			{
+				std::cerr << "Nieprawidlowy profil " << value << " (oczekiwano pietra:windy:ruch)\n";
+				return EXIT_FAILURE;
+			}
+			profiles.push_back(profile);
+		}
+		else if (arg == "--ziarno") config.seed = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+		else
+		{
+			std::cerr << "Nieznana opcja " << arg << "\n";
+			printUsage();
+			return EXIT_FAILURE;
+		}
+	}
+	if (config.buildings < 1 || config.building.floors < 2 || config.building.cars < 1 || config.duration <= 0.0 || config.epoch <= 0.0
+		|| config.building.decks < 1 || config.building.decks > MAX_DECKS
+		|| config.building.carsPerShaft < 1 || config.building.carsPerShaft > MAX_CARS_PER_SHAFT
+		|| config.building.controllerTick < 0.0)
+	{
+		std::cerr << "Nieprawidlowe parametry symulacji\n";
+		return EXIT_FAILURE;
+	}
+
+	if (!journeyDumpPath.empty())
+	{
+		return dumpJourneyLog(journeyDumpPath) ? 0 : EXIT_FAILURE;
+	}
+
+	if (!tracePath.empty() && !Trace::enabled)
+	{
+		std::cerr << "Slad czasowy niedostepny: program skompilowano bez SYMULATOR_TRACE\n";
+	}
+	Trace::setThreadName("main");
+
+	if (tune)
+	{
+		if (profiles.empty())
+		{
+			profiles.push_back(config.building);
+		}
+		for (auto& profile : profiles)
+		{
+			profile.pattern = config.building.pattern;
+			profile.learnDemand = config.building.learnDemand;
+			profile.decks = config.building.decks;
+			profile.carsPerShaft = config.building.carsPerShaft;
+		}
+		tuning.workers = config.workers;
+		tuning.seed = config.seed;
+		if (durationSet)
+		{
+			tuning.duration = config.duration;
+		}
+		runTuning(tuning, profiles);
+		if (!tracePath.empty() && Trace::enabled && !Trace::exportChromeTrace(tracePath))
+		{
+			std::cerr << "Nie mozna zapisac sladu do " << tracePath << "\n";
+			return EXIT_FAILURE;
+		}
+		return 0;
+	}
+
+	if (!timelapse.output.empty())
+	{
+		// Frames may go to standard output, so the summary goes to the error stream then
+		std::ostream& report = timelapse.output == "-" ? std::cerr : std::cout;
+		timelapse.building = config.building;
+		timelapse.building.seed = config.seed;
+		timelapse.duration = config.duration;
+		timelapse.workers = config.workers;
+		timelapse.forceDynamic = config.forceDynamic;
+		auto start = std::chrono::steady_clock::now();
+		timelapseResult result = Timelapse(timelapse).run();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (!result.ok)
+		{
+			std::cerr << result.error << "\n";
+			return EXIT_FAILURE;
+		}
+		report << "Klatki: " << result.frames << ", watki: " << result.workers << "\n"
+			<< "Pasazerowie: " << result.metrics.arrived << " przybylo, " << result.metrics.delivered << " dowiezionych, "
+			<< result.metrics.arrived - result.metrics.boarded << " czeka na pietrach\n"
+			<< "Czas obliczen: " << seconds << " s (" << result.frames / std::max(seconds, 1e-9) << " klatek/s)\n";
+		if (!tracePath.empty() && Trace::enabled && !Trace::exportChromeTrace(tracePath))
+		{
+			std::cerr << "Nie mozna zapisac sladu do " << tracePath << "\n";
+			return EXIT_FAILURE;
+		}
+		return 0;
+	}
+
+	std::unique_ptr<JourneyLog> journeyLog;
+	if (!journeyPath.empty())
+	{
+		journeyLog = std::make_unique<JourneyLog>(journeyPath);
+		if (!journeyLog->isOpen())
+		{
+			std::cerr << "Nie mozna otworzyc dziennika " << journeyPath << "\n";
+			return EXIT_FAILURE;
+		}
+		config.building.journeyLog = journeyLog.get();
+	}
+
+	RemoteController controller;
+	if (!controllerPath.empty())
+	{
+		std::cout << "Oczekiwanie na sterownik na " << controllerPath << "...\n" << std::flush;
+		if (!controller.open(controllerPath, config.building))
+		{
+			std::cerr << controller.error() << "\n";
+			return EXIT_FAILURE;
+		}
+		config.building.controller = &controller;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	Campus campus(config);
+	campusMetrics result = campus.run();
+	if (journeyLog && !journeyLog->close())
+	{
+		std::cerr << "Blad zapisu dziennika " << journeyPath << "\n";
+		return EXIT_FAILURE;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	controller.close();
+
+	const auto& total = result.total;
+	std::cout << "Budynki: " << config.buildings << ", watki: " << result.workers << ", epoki: " << result.epochs << "\n"
+		<< "Pasazerowie: " << total.arrived << " przybylo, " << total.delivered << " dowiezionych, "
+		<< total.arrived - total.boarded << " czeka na pietrach\n"
+		<< "Sredni czas oczekiwania: " << (total.boarded ? total.totalWait / total.boarded : 0.0) << " s"
+		<< " (95. percentyl: ";
+	printWait(std::cout, waitPercentile(total, 0.95));
+	std::cout << " s)\n"
+		<< "Zuzycie energii: " << total.energy << " kWh\n"
+		<< "Szczytowe zapotrzebowanie: " << result.peakDemand << " kW (od " << result.peakDemandTime << " s)\n"
+		<< "Czas obliczen: " << seconds << " s\n";
+	if (journeyLog)
+	{
+		std::cout << "Dziennik: " << journeyLog->recordsWritten() << " przejazdow zapisano w " << journeyPath << "\n";
+	}
+	if (!controllerPath.empty())
+	{
+		std::cout << "Sterownik: " << controller.rounds() << " rund, sredni czas odpowiedzi "
+			<< controller.meanRoundTrip() * 1e6 << " us\n";
+		if (!controller.error().empty())
+		{
+			std::cerr << "Sterownik odlaczony (" << controller.error() << "), dalej sterowala regula wbudowana\n";
+		}
+	}
+	if (!tracePath.empty() && Trace::enabled && !Trace::exportChromeTrace(tracePath))
+	{
+		std::cerr << "Nie mozna zapisac sladu do " << tracePath << "\n";
+		return EXIT_FAILURE;
+	}
+	return 0;
+}
@@ -0,0 +1,391 @@
+#include "JourneyLog.h"
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	std::atomic<uint64_t> nextLogId{ 1 };
+
+	int64_t toMilliseconds(double seconds)
+	{
+		return static_cast<int64_t>(std::llround(seconds * 1000.0));
+	}
+
+	constexpr size_t MAX_VARINT_BYTES = 10;
+
+	// Writes one zigzag varint at out, which must have room for MAX_VARINT_BYTES
+	uint8_t* putVarint(uint8_t* out, int64_t value)
+	{
+		uint64_t v = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); // zigzag
+		while (v >= 0x80)
+		{
+			*out++ = static_cast<uint8_t>(v | 0x80);
+			v >>= 7;
+		}
+		*out++ = static_cast<uint8_t>(v);
+		return out;
+	}
+
+	// Encoders write to a buffer with room for rows * MAX_VARINT_BYTES and return the end
+	template<typename T>
+	uint8_t* encodeColumn(uint8_t* out, const T* values, size_t rows, bool delta)
+	{
+		int64_t previous = 0;
+		for (size_t i = 0; i < rows; i++)
+		{
+			int64_t value = static_cast<int64_t>(values[i]);
+			out = putVarint(out, delta ? value - previous : value);
+			previous = value;
+		}
+		return out;
+	}
+
+	// Reads one zigzag varint from [pos, end); false if the block ends inside it
+	bool getVarint(const uint8_t*& pos, const uint8_t* end, int64_t& value)
+	{
+		uint64_t v = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			if (pos == end)
+			{
+				return false;
+			}
+			uint8_t byte = *pos++;
+			v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+			{
+				value = static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	double toSeconds(int64_t milliseconds)
+	{
+		return static_cast<double>(milliseconds) / 1000.0;
+	}
+
+	template<typename T>
+	uint8_t* encodeDifference(uint8_t* out, const T* values, const T* base, size_t rows)
+	{
+		for (size_t i = 0; i < rows; i++)
+		{
+			out = putVarint(out, static_cast<int64_t>(values[i]) - static_cast<int64_t>(base[i]));
+		}
+		return out;
+	}
+}
+
+JourneyLog::JourneyLog(const std::string& path) : id(nextLogId.fetch_add(1)), file(path, std::ios::binary)
+{
+	open = static_cast<bool>(file);
+	if (!open)
+	{
+		return;
+	}
+	writeBytes("SWJL", 4);
+	writeBytes(&JOURNEY_LOG_VERSION, sizeof(JOURNEY_LOG_VERSION));
+	columns = std::make_unique<chunk>();
+	writer = std::thread(&JourneyLog::writerLoop, this);
+}
+
+JourneyLog::~JourneyLog()
+{
+	close();
+}
+
+JourneyLog::threadSlot& JourneyLog::localSlot()
+{
+	thread_local threadSlot slot;
+	if (slot.logId != id)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		active.push_back(takeSpare());
+		slot = { id, active.size() - 1, active.back().get() };
+	}
+	return slot;
+}
+
+std::unique_ptr<JourneyLog::batch> JourneyLog::takeSpare()
+{
+	if (spare.empty())
+	{
+		return std::make_unique<batch>();
+	}
+	auto b = std::move(spare.back());
+	spare.pop_back();
+	b->rows = 0;
+	return b;
+}
+
+void JourneyLog::append(const journeyRecord& record)
+{
+	if (!open)
+	{
+		return;
+	}
+	threadSlot& slot = localSlot();
+	batch& b = *slot.current;
+	b.records[b.rows] = record;
+	if (++b.rows == JOURNEY_BATCH_ROWS)
+	{
+		// Hand the full batch to the writer and continue with a fresh one
+		std::lock_guard<std::mutex> lock(mutex);
+		full.push_back(std::move(active[slot.index]));
+		active[slot.index] = takeSpare();
+		slot.current = active[slot.index].get();
+		if (full.size() * JOURNEY_BATCH_ROWS >= JOURNEY_CHUNK_ROWS)
+		{
+			wake.notify_one();
+		}
+	}
+}
+
+void JourneyLog::writerLoop()
+{
+	std::vector<std::unique_ptr<batch>> taken;
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		wake.wait(lock, [this] { return stopping || full.size() * JOURNEY_BATCH_ROWS >= JOURNEY_CHUNK_ROWS; });
+		bool last = stopping;
+		taken.swap(full);
+		lock.unlock();
+		// Conversion, encoding and file I/O happen without holding the lock
+		for (const auto& b : taken)
+		{
+			addBatch(*b);
+		}
+		if (last && columns->rows > 0)
+		{
+			writeChunk(*columns);
+		}
+		lock.lock();
+		for (auto& b : taken)
+		{
+			spare.push_back(std::move(b));
+		}
+		taken.clear();
+		if (last)
+		{
+			break;
+		}
+	}
+}
+
+// Appends the batch to the writer's columns, writing every chunk that fills up
+void JourneyLog::addBatch(const batch& b)
+{
+	chunk& c = *columns;
+	for (size_t i = 0; i < b.rows; i++)
+	{
+		const journeyRecord& record = b.records[i];
+		size_t row = c.rows;
+		c.passengerId[row] = record.passengerId;
+		c.building[row] = record.building;
+		c.car[row] = record.car;
+		c.startFloor[row] = record.startFloor;
+		c.destination[row] = record.destination;
+		c.arrival[row] = toMilliseconds(record.arrivalTime);
+		c.board[row] = toMilliseconds(record.boardTime);
+		c.alight[row] = toMilliseconds(record.alightTime);
+		if (++c.rows == JOURNEY_CHUNK_ROWS)
+		{
+			writeChunk(c);
+			c.rows = 0;
+		}
+	}
+}
+
+bool JourneyLog::close()
+{
+	if (!open || closed)
+	{
+		return open;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto& b : active)
+		{
+			if (b && b->rows > 0)
+			{
+				full.push_back(std::move(b));
+			}
+		}
+		active.clear();
+		stopping = true;
+		wake.notify_one();
+	}
+	writer.join();
+	closed = true;
+
+	uint64_t footerOffset = fileOffset;
+	uint32_t columnCount = JOURNEY_COLUMNS;
+	uint32_t chunkCount = static_cast<uint32_t>(index.size());
+	writeBytes(&columnCount, sizeof(columnCount));
+	writeBytes(&chunkCount, sizeof(chunkCount));
+	for (const auto& entry : index)
+	{
+		writeBytes(&entry.rows, sizeof(entry.rows));
+		for (int i = 0; i < JOURNEY_COLUMNS; i++)
+		{
+			writeBytes(&entry.offsets[i], sizeof(entry.offsets[i]));
+			writeBytes(&entry.sizes[i], sizeof(entry.sizes[i]));
+		}
+	}
+	writeBytes(&footerOffset, sizeof(footerOffset));
+	writeBytes("SWJL", 4);
+	file.close();
+	open = static_cast<bool>(file);
+	return open;
+}
+
+void JourneyLog::writeChunk(const chunk& c)
+{
+	// Sized for the worst case once; every column block is encoded from its start
+	encoded.resize(JOURNEY_CHUNK_ROWS * MAX_VARINT_BYTES);
+	uint8_t* column = encoded.data();
+	journeyChunkIndex entry{ static_cast<uint32_t>(c.rows), {}, {} };
+	for (int i = 0; i < JOURNEY_COLUMNS; i++)
+	{
+		uint8_t* end = column;
+		switch (i)
+		{
+		case 0: end = encodeColumn(column, c.passengerId.data(), c.rows, true); break;
+		case 1: end = encodeColumn(column, c.building.data(), c.rows, false); break;
+		case 2: end = encodeColumn(column, c.car.data(), c.rows, false); break;
+		case 3: end = encodeColumn(column, c.startFloor.data(), c.rows, false); break;
+		case 4: end = encodeColumn(column, c.destination.data(), c.rows, false); break;
+		case 5: end = encodeColumn(column, c.arrival.data(), c.rows, true); break;
+		case 6: end = encodeDifference(column, c.board.data(), c.arrival.data(), c.rows); break;
+		case 7: end = encodeDifference(column, c.alight.data(), c.board.data(), c.rows); break;
+		}
+		entry.offsets[i] = fileOffset;
+		entry.sizes[i] = static_cast<uint32_t>(end - column);
+		writeBytes(column, static_cast<size_t>(end - column));
+	}
+	index.push_back(entry);
+	written.fetch_add(c.rows, std::memory_order_relaxed);
+}
+
+void JourneyLog::writeBytes(const void* data, size_t size)
+{
+	file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+	fileOffset += size;
+}
+
+JourneyLogReader::JourneyLogReader(const std::string& path) : file(path, std::ios::binary)
+{
+	if (!file)
+	{
+		fail("Nie mozna otworzyc dziennika " + path);
+		return;
+	}
+	char magic[4];
+	uint32_t version = 0;
+	file.read(magic, 4);
+	file.read(reinterpret_cast<char*>(&version), sizeof(version));
+	if (!file || std::memcmp(magic, "SWJL", 4) != 0)
+	{
+		fail("To nie jest dziennik przejazdow: " + path);
+		return;
+	}
+	if (version != JOURNEY_LOG_VERSION)
+	{
+		fail("Nieobslugiwana wersja dziennika " + std::to_string(version));
+		return;
+	}
+
+	uint64_t footerOffset = 0;
+	file.seekg(-static_cast<std::streamoff>(sizeof(footerOffset) + 4), std::ios::end);
+	file.read(reinterpret_cast<char*>(&footerOffset), sizeof(footerOffset));
+	file.read(magic, 4);
+	if (!file || std::memcmp(magic, "SWJL", 4) != 0)
+	{
+		fail("Dziennik bez stopki (zapis nie zostal zakonczony): " + path);
+		return;
+	}
+	uint32_t columnCount = 0;
+	uint32_t chunks = 0;
+	file.seekg(static_cast<std::streamoff>(footerOffset));
+	file.read(reinterpret_cast<char*>(&columnCount), sizeof(columnCount));
+	file.read(reinterpret_cast<char*>(&chunks), sizeof(chunks));
+	if (!file || columnCount != JOURNEY_COLUMNS)
+	{
+		fail("Uszkodzona stopka dziennika " + path);
+		return;
+	}
+	index.resize(chunks);
+	for (auto& entry : index)
+	{
+		file.read(reinterpret_cast<char*>(&entry.rows), sizeof(entry.rows));
+		for (int i = 0; i < JOURNEY_COLUMNS; i++)
+		{
+			file.read(reinterpret_cast<char*>(&entry.offsets[i]), sizeof(entry.offsets[i]));
+			file.read(reinterpret_cast<char*>(&entry.sizes[i]), sizeof(entry.sizes[i]));
+		}
+		records += entry.rows;
+	}
+	if (!file)
+	{
+		fail("Uszkodzona stopka dziennika " + path);
+		return;
+	}
+	open = true;
+}
+
+bool JourneyLogReader::readChunk(size_t i, std::vector<journeyRecord>& out)
+{
+	if (!open || i >= index.size())
+	{
+		return fail("Brak fragmentu " + std::to_string(i) + " dziennika");
+	}
+	const journeyChunkIndex& entry = index[i];
+	out.assign(entry.rows, journeyRecord{});
+	for (int col = 0; col < JOURNEY_COLUMNS; col++)
+	{
+		column.resize(entry.sizes[col]);
+		file.seekg(static_cast<std::streamoff>(entry.offsets[col]));
+		file.read(reinterpret_cast<char*>(column.data()), static_cast<std::streamsize>(column.size()));
+		if (!file)
+		{
+			return fail("Nie mozna odczytac fragmentu " + std::to_string(i) + " dziennika");
+		}
+		const uint8_t* pos = column.data();
+		const uint8_t* end = pos + column.size();
+		int64_t previous = 0;
+		for (auto& r : out)
+		{
+			int64_t value = 0;
+			if (!getVarint(pos, end, value))
+			{
+				return fail("Uszkodzona kolumna " + std::to_string(col) + " we fragmencie " + std::to_string(i));
+			}
+			// Columns 6 and 7 are differences to columns 5 and 6, so decoding in column
+			// order has the base of every difference ready
+			switch (col)
+			{
+			case 0: r.passengerId = static_cast<uint64_t>(previous += value); break;
+			case 1: r.building = static_cast<uint32_t>(value); break;
+			case 2: r.car = static_cast<int16_t>(value); break;
+			case 3: r.startFloor = static_cast<int16_t>(value); break;
+			case 4: r.destination = static_cast<int16_t>(value); break;
+			case 5: r.arrivalTime = toSeconds(previous += value); break;
+			case 6: r.boardTime = toSeconds(toMilliseconds(r.arrivalTime) + value); break;
+			case 7: r.alightTime = toSeconds(toMilliseconds(r.boardTime) + value); break;
+			}
+		}
+		if (pos != end)
+		{
+			return fail("Uszkodzona kolumna " + std::to_string(col) + " we fragmencie " + std::to_string(i));
+		}
+	}
+	return true;
+}
+
+bool JourneyLogReader::fail(const std::string& message)
+{
+	lastError = message;
+	return false;
+}
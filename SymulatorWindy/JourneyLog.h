@@ -0,0 +1,156 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Log of every delivered passenger, written as a compressed columnar file.
+//
+// Records are appended as they are to a small batch owned by the calling thread, so
+// logging costs a simulation thread one record copy and keeps its cache for the engine.
+// Only a full batch is handed to the background writer thread (one mutex lock per
+// JOURNEY_BATCH_ROWS records), and the writer is woken once per chunk's worth of batches.
+// The writer converts the records into columns, encodes every column separately and
+// appends it to the file, so a chunk may hold the records of several threads.
+//
+// File layout (all integers little-endian):
+//   "SWJL" u32 version
+//   chunk*          each chunk: JOURNEY_COLUMNS column blocks, in column order
+//   footer          u32 columnCount, u32 chunkCount,
+//                   per chunk: u32 rows, per column: u64 offset, u32 bytes
+//   u64 footerOffset "SWJL"
+// Column blocks are LEB128 varints of zigzag-encoded values. Columns marked "delta"
+// store the difference to the previous row of the same chunk. Times are in milliseconds
+// of simulated time.
+//   0 passengerId (delta)  1 building  2 car  3 startFloor  4 destination
+//   5 arrival (delta)      6 board - arrival   7 alight - board
+// JourneyLogReader reads the file back, one chunk at a time.
+
+constexpr size_t JOURNEY_CHUNK_ROWS = 16384; // Records per column chunk
+constexpr size_t JOURNEY_BATCH_ROWS = 256; // Records a producer thread collects before handing them over
+constexpr int JOURNEY_COLUMNS = 8;
+constexpr uint32_t JOURNEY_LOG_VERSION = 1;
+
+struct journeyRecord
+{
+	uint64_t passengerId;
+	uint32_t building;
+	int16_t car;
+	int16_t startFloor;
+	int16_t destination;
+	double arrivalTime; // Seconds of simulated time
+	double boardTime;
+	double alightTime;
+};
+
+// Footer entry of one chunk
+struct journeyChunkIndex
+{
+	uint32_t rows;
+	std::array<uint64_t, JOURNEY_COLUMNS> offsets;
+	std::array<uint32_t, JOURNEY_COLUMNS> sizes;
+};
+
+class JourneyLog
+{
+public:
+	explicit JourneyLog(const std::string& path);
+	~JourneyLog();
+
+	JourneyLog(const JourneyLog&) = delete;
+	JourneyLog& operator=(const JourneyLog&) = delete;
+
+	bool isOpen() const { return open; }
+	// Thread-safe. Does not block unless the calling thread's batch is full.
+	void append(const journeyRecord& record);
+	// Writes the remaining batches of all threads and the footer. Call only after every
+	// thread has stopped appending. Returns false if writing failed.
+	bool close();
+	uint64_t recordsWritten() const { return written.load(std::memory_order_relaxed); }
+
+private:
+	struct batch
+	{
+		size_t rows = 0;
+		std::array<journeyRecord, JOURNEY_BATCH_ROWS> records;
+	};
+
+	// Columns of the chunk the writer is filling
+	struct chunk
+	{
+		size_t rows = 0;
+		std::array<uint64_t, JOURNEY_CHUNK_ROWS> passengerId;
+		std::array<uint32_t, JOURNEY_CHUNK_ROWS> building;
+		std::array<int16_t, JOURNEY_CHUNK_ROWS> car;
+		std::array<int16_t, JOURNEY_CHUNK_ROWS> startFloor;
+		std::array<int16_t, JOURNEY_CHUNK_ROWS> destination;
+		std::array<int64_t, JOURNEY_CHUNK_ROWS> arrival;
+		std::array<int64_t, JOURNEY_CHUNK_ROWS> board;
+		std::array<int64_t, JOURNEY_CHUNK_ROWS> alight;
+	};
+
+	// Calling thread's batch for this log, remembered in a thread_local slot
+	struct threadSlot
+	{
+		uint64_t logId = 0;
+		size_t index = 0; // Position in active
+		batch* current = nullptr;
+	};
+
+	const uint64_t id; // Distinguishes logs in the thread_local slots
+	std::ofstream file;
+	bool open = false;
+	bool closed = false;
+	uint64_t fileOffset = 0;
+	std::vector<journeyChunkIndex> index;
+	std::unique_ptr<chunk> columns; // Writer thread's chunk
+	std::vector<uint8_t> encoded; // Writer thread's buffer for one column block
+	std::atomic<uint64_t> written{ 0 };
+
+	std::mutex mutex; // Guards everything below
+	std::condition_variable wake;
+	std::vector<std::unique_ptr<batch>> active; // Current batch of every producer thread
+	std::vector<std::unique_ptr<batch>> full; // Waiting for the writer
+	std::vector<std::unique_ptr<batch>> spare; // Written batches, reused by producers
+	bool stopping = false;
+	std::thread writer;
+
+	threadSlot& localSlot();
+	std::unique_ptr<batch> takeSpare();
+	void writerLoop();
+	void addBatch(const batch& b);
+	void writeChunk(const chunk& c);
+	void writeBytes(const void* data, size_t size);
+};
+
+// Reads a file written by JourneyLog. The footer is read on opening; chunks are decoded
+// on request, so a large log can be scanned without holding it in memory. Times come
+// back rounded to milliseconds, as they were stored.
+class JourneyLogReader
+{
+public:
+	explicit JourneyLogReader(const std::string& path);
+
+	bool isOpen() const { return open; }
+	const std::string& error() const { return lastError; }
+	size_t chunkCount() const { return index.size(); }
+	uint64_t recordCount() const { return records; }
+	// Replaces out with the rows of chunk i. Returns false if the chunk is damaged.
+	bool readChunk(size_t i, std::vector<journeyRecord>& out);
+
+private:
+	std::ifstream file;
+	bool open = false;
+	std::string lastError;
+	std::vector<journeyChunkIndex> index;
+	uint64_t records = 0;
+	std::vector<uint8_t> column; // Reused buffer for one column block
+
+	bool fail(const std::string& message);
+};
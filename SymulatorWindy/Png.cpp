@@ -0,0 +1,539 @@
+#include "Png.h"
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+	constexpr int MAX_CODE_BITS = 15; // Longest Huffman code in deflate
+	constexpr int MAX_LITERAL_CODES = 288;
+	constexpr int MAX_DISTANCE_CODES = 30;
+
+	constexpr std::array<uint16_t, 29> LENGTH_BASE = {
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	constexpr std::array<uint8_t, 29> LENGTH_EXTRA = {
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	constexpr std::array<uint16_t, 30> DISTANCE_BASE = {
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+		1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	constexpr std::array<uint8_t, 30> DISTANCE_EXTRA = {
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	constexpr std::array<uint8_t, 19> CODE_LENGTH_ORDER = {
+		16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	// Reads the deflate bit stream, least significant bit first
+	class BitReader
+	{
+	public:
+		BitReader(const uint8_t* data_, size_t size_) : data(data_), size(size_) {}
+
+		// Returns -1 past the end of the input
+		int bits(int count)
+		{
+			uint32_t value = buffer;
+			while (available < count)
+			{
+				if (position == size)
+				{
+					return -1;
+				}
+				value |= static_cast<uint32_t>(data[position++]) << available;
+				available += 8;
+			}
+			buffer = value >> count;
+			available -= count;
+			return static_cast<int>(value & ((1u << count) - 1));
+		}
+
+		void alignToByte()
+		{
+			buffer = 0;
+			available = 0;
+		}
+
+		size_t offset() const { return position; }
+		void skip(size_t count) { position += count; }
+		size_t remaining() const { return size - position; }
+
+	private:
+		const uint8_t* data;
+		size_t size;
+		size_t position = 0;
+		uint32_t buffer = 0;
+		int available = 0;
+	};
+
+	// Canonical Huffman code: number of codes of every length and the symbols in code order
+	struct huffmanCode
+	{
+		std::array<uint16_t, MAX_CODE_BITS + 1> counts{};
+		std::array<uint16_t, MAX_LITERAL_CODES> symbols{};
+	};
+
+	// Returns false if the lengths do not form a valid code
+	bool buildCode(huffmanCode& code, const uint8_t* lengths, int count)
+	{
+		code.counts.fill(0);
+		for (int i = 0; i < count; i++)
+		{
+			++code.counts[lengths[i]];
+		}
+		int left = 1;
+		for (int len = 1; len <= MAX_CODE_BITS; len++)
+		{
+			left = left * 2 - code.counts[len];
+			if (left < 0)
+			{
+				return false; // Over-subscribed
+			}
+		}
+		std::array<uint16_t, MAX_CODE_BITS + 1> offsets{};
+		for (int len = 1; len < MAX_CODE_BITS; len++)
+		{
+			offsets[len + 1] = offsets[len] + code.counts[len];
+		}
+		for (int i = 0; i < count; i++)
+		{
+			if (lengths[i] != 0)
+			{
+				code.symbols[offsets[lengths[i]]++] = static_cast<uint16_t>(i);
+			}
+		}
+		return true;
+	}
+
+	// Decodes one symbol bit by bit; the sprites are small, so speed does not matter here
+	int decodeSymbol(BitReader& in, const huffmanCode& code)
+	{
+		int value = 0;
+		int first = 0;
+		int index = 0;
+		for (int len = 1; len <= MAX_CODE_BITS; len++)
+		{
+			int bit = in.bits(1);
+			if (bit < 0)
+			{
+				return -1;
+			}
+			value |= bit;
+			int count = code.counts[len];
+			if (value - count < first)
+			{
+				return code.symbols[index + (value - first)];
+			}
+			index += count;
+			first = (first + count) << 1;
+			value <<= 1;
+		}
+		return -1;
+	}
+
+	bool inflateCodes(BitReader& in, const huffmanCode& literals, const huffmanCode& distances, std::vector<uint8_t>& out)
+	{
+		while (true)
+		{
+			int symbol = decodeSymbol(in, literals);
+			if (symbol < 0)
+			{
+				return false;
+			}
+			if (symbol < 256)
+			{
+				out.push_back(static_cast<uint8_t>(symbol));
+				continue;
+			}
+			if (symbol == 256)
+			{
+				return true; // End of block
+			}
+			symbol -= 257;
+			if (symbol >= static_cast<int>(LENGTH_BASE.size()))
+			{
+				return false;
+			}
+			int extra = in.bits(LENGTH_EXTRA[symbol]);
+			int distanceSymbol = decodeSymbol(in, distances);
+			if (extra < 0 || distanceSymbol < 0 || distanceSymbol >= MAX_DISTANCE_CODES)
+			{
+				return false;
+			}
+			int length = LENGTH_BASE[symbol] + extra;
+			int distanceExtra = in.bits(DISTANCE_EXTRA[distanceSymbol]);
+			if (distanceExtra < 0)
+			{
+				return false;
+			}
+			size_t distance = DISTANCE_BASE[distanceSymbol] + static_cast<size_t>(distanceExtra);
+			if (distance > out.size())
+			{
+				return false;
+			}
+			size_t from = out.size() - distance;
+			for (int i = 0; i < length; i++)
+			{
+				out.push_back(out[from + i]); // May overlap the bytes being written
+			}
+		}
+	}
+
+	bool readDynamicCodes(BitReader& in, huffmanCode& literals, huffmanCode& distances)
+	{
+		int literalCount = in.bits(5);
+		int distanceCount = in.bits(5);
+		int lengthCount = in.bits(4);
+		if (literalCount < 0 || distanceCount < 0 || lengthCount < 0)
+		{
+			return false;
+		}
+		literalCount += 257;
+		distanceCount += 1;
+		lengthCount += 4;
+		if (literalCount > MAX_LITERAL_CODES || distanceCount > MAX_DISTANCE_CODES)
+		{
+			return false;
+		}
+
+		std::array<uint8_t, MAX_LITERAL_CODES + MAX_DISTANCE_CODES> lengths{};
+		for (int i = 0; i < lengthCount; i++)
+		{
+			int len = in.bits(3);
+			if (len < 0)
+			{
+				return false;
+			}
+			lengths[CODE_LENGTH_ORDER[i]] = static_cast<uint8_t>(len);
+		}
+		huffmanCode lengthCode;
+		if (!buildCode(lengthCode, lengths.data(), static_cast<int>(CODE_LENGTH_ORDER.size())))
+		{
+			return false;
+		}
+
+		lengths.fill(0);
+		int total = literalCount + distanceCount;
+		for (int i = 0; i < total;)
+		{
+			int symbol = decodeSymbol(in, lengthCode);
+			if (symbol < 0)
+			{
+				return false;
+			}
+			if (symbol < 16)
+			{
+				lengths[i++] = static_cast<uint8_t>(symbol);
+				continue;
+			}
+			int repeat = 0;
+			uint8_t value = 0;
+			if (symbol == 16)
+			{
+				if (i == 0)
+				{
+					return false; // Nothing to repeat
+				}
+				value = lengths[i - 1];
+				repeat = 3 + in.bits(2);
+			}
+			else if (symbol == 17)
+			{
+				repeat = 3 + in.bits(3);
+			}
+			else
+			{
+				repeat = 11 + in.bits(7);
+			}
+			if (repeat < 3 || i + repeat > total)
+			{
+				return false;
+			}
+			while (repeat-- > 0)
+			{
+				lengths[i++] = value;
+			}
+		}
+		if (lengths[256] == 0)
+		{
+			return false; // No end-of-block code
+		}
+		return buildCode(literals, lengths.data(), literalCount)
+			&& buildCode(distances, lengths.data() + literalCount, distanceCount);
+	}
+
+	void fixedCodes(huffmanCode& literals, huffmanCode& distances)
+	{
+		std::array<uint8_t, MAX_LITERAL_CODES> lengths{};
+		for (int i = 0; i < MAX_LITERAL_CODES; i++)
+		{
+			lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+		}
+		buildCode(literals, lengths.data(), MAX_LITERAL_CODES);
+		lengths.fill(5);
+		buildCode(distances, lengths.data(), MAX_DISTANCE_CODES);
+	}
+
+	uint32_t adler32(const std::vector<uint8_t>& data)
+	{
+		uint32_t a = 1;
+		uint32_t b = 0;
+		for (uint8_t byte : data)
+		{
+			a = (a + byte) % 65521;
+			b = (b + a) % 65521;
+		}
+		return (b << 16) | a;
+	}
+
+	uint32_t readBigEndian(const uint8_t* p)
+	{
+		return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+			| (static_cast<uint32_t>(p[2]) << 8) | p[3];
+	}
+
+	int paeth(int a, int b, int c)
+	{
+		int p = a + b - c;
+		int pa = std::abs(p - a);
+		int pb = std::abs(p - b);
+		int pc = std::abs(p - c);
+		if (pa <= pb && pa <= pc)
+		{
+			return a;
+		}
+		return pb <= pc ? b : c;
+	}
+
+	// Reverses the per-row filters in place; rows start with their filter type byte
+	bool unfilter(std::vector<uint8_t>& data, int width, int height, int channels)
+	{
+		size_t stride = static_cast<size_t>(width) * channels;
+		if (data.size() < (stride + 1) * height)
+		{
+			return false;
+		}
+		for (int y = 0; y < height; y++)
+		{
+			uint8_t* row = data.data() + y * (stride + 1);
+			const uint8_t* previous = y > 0 ? row - (stride + 1) + 1 : nullptr;
+			uint8_t filter = row[0];
+			++row;
+			for (size_t x = 0; x < stride; x++)
+			{
+				int left = x >= static_cast<size_t>(channels) ? row[x - channels] : 0;
+				int up = previous ? previous[x] : 0;
+				int upLeft = previous && x >= static_cast<size_t>(channels) ? previous[x - channels] : 0;
+				switch (filter)
+				{
+				case 0: break;
+				case 1: row[x] = static_cast<uint8_t>(row[x] + left); break;
+				case 2: row[x] = static_cast<uint8_t>(row[x] + up); break;
+				case 3: row[x] = static_cast<uint8_t>(row[x] + (left + up) / 2); break;
+				case 4: row[x] = static_cast<uint8_t>(row[x] + paeth(left, up, upLeft)); break;
+				default: return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+bool inflateZlib(const uint8_t* data, size_t size, std::vector<uint8_t>& out, std::string& error)
+{
+	out.clear();
+	if (size < 6 || (data[0] & 0x0F) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20))
+	{
+		error = "nieobslugiwany naglowek zlib";
+		return false;
+	}
+	BitReader in(data + 2, size - 2);
+	huffmanCode literals;
+	huffmanCode distances;
+	bool last = false;
+	while (!last)
+	{
+		int header = in.bits(3);
+		if (header < 0)
+		{
+			error = "uciete dane deflate";
+			return false;
+		}
+		last = header & 1;
+		int type = header >> 1;
+		if (type == 0)
+		{
+			// Stored block: byte aligned LEN, NLEN and raw bytes
+			in.alignToByte();
+			size_t at = in.offset();
+			if (in.remaining() < 4)
+			{
+				error = "uciete dane deflate";
+				return false;
+			}
+			const uint8_t* p = data + 2 + at;
+			unsigned length = p[0] | (p[1] << 8);
+			unsigned check = p[2] | (p[3] << 8);
+			if ((length ^ 0xFFFFu) != check || in.remaining() < 4 + length)
+			{
+				error = "uszkodzony blok deflate";
+				return false;
+			}
+			out.insert(out.end(), p + 4, p + 4 + length);
+			in.skip(4 + length);
+			continue;
+		}
+		if (type == 1)
+		{
+			fixedCodes(literals, distances);
+		}
+		else if (type != 2 || !readDynamicCodes(in, literals, distances))
+		{
+			error = "uszkodzony blok deflate";
+			return false;
+		}
+		if (!inflateCodes(in, literals, distances, out))
+		{
+			error = "uszkodzony blok deflate";
+			return false;
+		}
+	}
+	size_t end = 2 + in.offset();
+	if (size - end < 4 || readBigEndian(data + end) != adler32(out))
+	{
+		error = "bledna suma kontrolna zlib";
+		return false;
+	}
+	return true;
+}
+
+bool decodePng(const std::vector<uint8_t>& file, rgbaImage& image, std::string& error)
+{
+	static constexpr uint8_t SIGNATURE[8] = { 137, 'P', 'N', 'G', 13, 10, 26, 10 };
+	if (file.size() < 8 || std::memcmp(file.data(), SIGNATURE, 8) != 0)
+	{
+		error = "to nie jest plik PNG";
+		return false;
+	}
+	int width = 0;
+	int height = 0;
+	int colorType = -1;
+	std::vector<uint8_t> compressed;
+	std::vector<uint8_t> palette; // RGBA entries
+	for (size_t at = 8; at + 12 <= file.size();)
+	{
+		uint32_t length = readBigEndian(file.data() + at);
+		const uint8_t* type = file.data() + at + 4;
+		const uint8_t* body = type + 4;
+		if (length > file.size() - at - 12)
+		{
+			error = "uciety fragment PNG";
+			return false;
+		}
+		if (std::memcmp(type, "IHDR", 4) == 0 && length >= 13)
+		{
+			width = static_cast<int>(readBigEndian(body));
+			height = static_cast<int>(readBigEndian(body + 4));
+			colorType = body[9];
+			if (body[8] != 8 || body[12] != 0 || width <= 0 || height <= 0)
+			{
+				error = "obslugiwane sa tylko 8-bitowe obrazy bez przeplotu";
+				return false;
+			}
+		}
+		else if (std::memcmp(type, "PLTE", 4) == 0)
+		{
+			palette.clear();
+			for (uint32_t i = 0; i + 3 <= length; i += 3)
+			{
+				palette.insert(palette.end(), { body[i], body[i + 1], body[i + 2], 255 });
+			}
+		}
+		else if (std::memcmp(type, "tRNS", 4) == 0 && colorType == 3)
+		{
+			for (uint32_t i = 0; i < length && i * 4 + 3 < palette.size(); i++)
+			{
+				palette[i * 4 + 3] = body[i];
+			}
+		}
+		else if (std::memcmp(type, "IDAT", 4) == 0)
+		{
+			compressed.insert(compressed.end(), body, body + length);
+		}
+		else if (std::memcmp(type, "IEND", 4) == 0)
+		{
+			break;
+		}
+		at += 12 + length;
+	}
+
+	int channels = 0;
+	switch (colorType)
+	{
+	case 0: channels = 1; break;
+	case 2: channels = 3; break;
+	case 3: channels = 1; break;
+	case 4: channels = 2; break;
+	case 6: channels = 4; break;
+	default:
+		error = "nieobslugiwany typ koloru PNG";
+		return false;
+	}
+	std::vector<uint8_t> raw;
+	if (!inflateZlib(compressed.data(), compressed.size(), raw, error))
+	{
+		return false;
+	}
+	if (!unfilter(raw, width, height, channels))
+	{
+		error = "uszkodzone dane obrazu PNG";
+		return false;
+	}
+
+	image.width = width;
+	image.height = height;
+	image.pixels.resize(static_cast<size_t>(width) * height * 4);
+	size_t stride = static_cast<size_t>(width) * channels;
+	for (int y = 0; y < height; y++)
+	{
+		const uint8_t* row = raw.data() + y * (stride + 1) + 1;
+		uint8_t* pixel = image.pixels.data() + static_cast<size_t>(y) * width * 4;
+		for (int x = 0; x < width; x++, pixel += 4)
+		{
+			const uint8_t* s = row + static_cast<size_t>(x) * channels;
+			switch (colorType)
+			{
+			case 0: pixel[0] = pixel[1] = pixel[2] = s[0]; pixel[3] = 255; break;
+			case 2: pixel[0] = s[0]; pixel[1] = s[1]; pixel[2] = s[2]; pixel[3] = 255; break;
+			case 4: pixel[0] = pixel[1] = pixel[2] = s[0]; pixel[3] = s[1]; break;
+			case 6: std::memcpy(pixel, s, 4); break;
+			case 3:
+				if (static_cast<size_t>(s[0]) * 4 + 3 >= palette.size())
+				{
+					error = "indeks poza paleta PNG";
+					return false;
+				}
+				std::memcpy(pixel, palette.data() + s[0] * 4, 4);
+				break;
+			}
+		}
+	}
+	image.updateOpacity();
+	return true;
+}
+
+bool loadPng(const std::string& path, rgbaImage& image, std::string& error)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		error = "nie mozna otworzyc " + path;
+		return false;
+	}
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (!decodePng(data, image, error))
+	{
+		error = path + ": " + error;
+		return false;
+	}
+	return true;
+}
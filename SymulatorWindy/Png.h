@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Raster.h"
+
+// Self-contained PNG reader for the zdjencia sprites, so the offscreen renderer needs
+// no image library. Handles non-interlaced 8-bit greyscale, greyscale with alpha, RGB,
+// RGBA and palette images, with its own zlib/deflate decoder.
+
+bool decodePng(const std::vector<uint8_t>& file, rgbaImage& image, std::string& error);
+bool loadPng(const std::string& path, rgbaImage& image, std::string& error);
+
+// Decompresses a zlib stream (RFC 1950/1951) and checks its Adler-32 checksum
+bool inflateZlib(const uint8_t* data, size_t size, std::vector<uint8_t>& out, std::string& error);
@@ -0,0 +1,307 @@
+#include "Raster.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include "Png.h"
+
+namespace
+{
+	constexpr int GLYPH_WIDTH = 5;
+	constexpr int GLYPH_HEIGHT = 7;
+	constexpr int GLYPH_PIXELS_PER_EM = 8; // Font size at which glyphs are drawn unscaled
+
+	struct glyph
+	{
+		char character;
+		std::array<uint8_t, GLYPH_HEIGHT> rows; // Bit 4 is the leftmost pixel
+	};
+
+	constexpr glyph FONT[] = {
+		{ 'A', { 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 } },
+		{ 'B', { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E } },
+		{ 'C', { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E } },
+		{ 'D', { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C } },
+		{ 'E', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F } },
+		{ 'F', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 } },
+		{ 'G', { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F } },
+		{ 'H', { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 } },
+		{ 'I', { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+		{ 'J', { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C } },
+		{ 'K', { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 } },
+		{ 'L', { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F } },
+		{ 'M', { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 } },
+		{ 'N', { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 } },
+		{ 'O', { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+		{ 'P', { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 } },
+		{ 'Q', { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D } },
+		{ 'R', { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 } },
+		{ 'S', { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E } },
+		{ 'T', { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 } },
+		{ 'U', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+		{ 'V', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 } },
+		{ 'W', { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A } },
+		{ 'X', { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 } },
+		{ 'Y', { 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 } },
+		{ 'Z', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F } },
+		{ '0', { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E } },
+		{ '1', { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+		{ '2', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F } },
+		{ '3', { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E } },
+		{ '4', { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 } },
+		{ '5', { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E } },
+		{ '6', { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E } },
+		{ '7', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 } },
+		{ '8', { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E } },
+		{ '9', { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C } },
+		{ ':', { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 } },
+		{ '.', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C } },
+		{ ',', { 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 } },
+		{ '-', { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 } },
+		{ '+', { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 } },
+		{ '/', { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 } },
+		{ '%', { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 } },
+		{ '?', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 } },
+	};
+
+	// Folds lower case and Polish letters onto the glyphs of the font
+	char fontCharacter(wchar_t c)
+	{
+		switch (c)
+		{
+		// Polish letters, written as escapes so the file is plain ASCII
+		case L'\u0105': case L'\u0104': return 'A';
+		case L'\u0107': case L'\u0106': return 'C';
+		case L'\u0119': case L'\u0118': return 'E';
+		case L'\u0142': case L'\u0141': return 'L';
+		case L'\u0144': case L'\u0143': return 'N';
+		case L'\u00F3': case L'\u00D3': return 'O';
+		case L'\u015B': case L'\u015A': return 'S';
+		case L'\u017A': case L'\u0179': case L'\u017C': case L'\u017B': return 'Z';
+		default: break;
+		}
+		if (c >= L'a' && c <= L'z')
+		{
+			return static_cast<char>(c - L'a' + 'A');
+		}
+		return c < 128 ? static_cast<char>(c) : '?';
+	}
+
+	const glyph* findGlyph(char c)
+	{
+		for (const auto& g : FONT)
+		{
+			if (g.character == c)
+			{
+				return &g;
+			}
+		}
+		return nullptr;
+	}
+
+	// Blends one colour with straight alpha over the pixel
+	void blend(uint8_t* pixel, uint8_t r, uint8_t g, uint8_t b, unsigned alpha)
+	{
+		if (alpha == 255)
+		{
+			pixel[0] = r;
+			pixel[1] = g;
+			pixel[2] = b;
+			pixel[3] = 255;
+			return;
+		}
+		unsigned keep = 255 - alpha;
+		pixel[0] = static_cast<uint8_t>((r * alpha + pixel[0] * keep + 127) / 255);
+		pixel[1] = static_cast<uint8_t>((g * alpha + pixel[1] * keep + 127) / 255);
+		pixel[2] = static_cast<uint8_t>((b * alpha + pixel[2] * keep + 127) / 255);
+		pixel[3] = static_cast<uint8_t>(alpha + (pixel[3] * keep + 127) / 255);
+	}
+
+	// Fills the clipped rectangle [x, x + w) x [y, y + h) with a colour
+	void fillRect(rgbaImage& target, int x, int y, int w, int h, uint32_t argb)
+	{
+		int left = std::max(x, 0);
+		int top = std::max(y, 0);
+		int right = std::min(x + w, target.width);
+		int bottom = std::min(y + h, target.height);
+		unsigned alpha = argb >> 24;
+		if (alpha == 0)
+		{
+			return;
+		}
+		for (int row = top; row < bottom; row++)
+		{
+			uint8_t* pixel = target.pixels.data() + (static_cast<size_t>(row) * target.width + left) * 4;
+			for (int col = left; col < right; col++, pixel += 4)
+			{
+				blend(pixel, (argb >> 16) & 0xFF, (argb >> 8) & 0xFF, argb & 0xFF, alpha);
+			}
+		}
+	}
+
+	std::string fileName(const std::wstring& path)
+	{
+		size_t slash = path.find_last_of(L"\\/");
+		std::string name;
+		for (size_t i = slash == std::wstring::npos ? 0 : slash + 1; i < path.size(); i++)
+		{
+			name.push_back(path[i] < 128 ? static_cast<char>(path[i]) : '_');
+		}
+		return name;
+	}
+}
+
+void rgbaImage::resize(int width_, int height_)
+{
+	width = width_;
+	height = height_;
+	pixels.resize(static_cast<size_t>(width) * height * 4);
+}
+
+void rgbaImage::updateOpacity()
+{
+	opaque = true;
+	for (size_t i = 3; i < pixels.size(); i += 4)
+	{
+		if (pixels[i] != 255)
+		{
+			opaque = false;
+			return;
+		}
+	}
+}
+
+bool SpriteCache::load(const std::string& name, std::string& error)
+{
+	rgbaImage image;
+	if (!loadPng(directory + "/" + name, image, error))
+	{
+		return false;
+	}
+	images[name] = std::move(image);
+	return true;
+}
+
+const rgbaImage* SpriteCache::find(const std::wstring& imagePath) const
+{
+	auto it = images.find(fileName(imagePath));
+	return it == images.end() ? nullptr : &it->second;
+}
+
+void fillImage(rgbaImage& target, uint32_t argb)
+{
+	uint8_t color[4] = { static_cast<uint8_t>(argb >> 16), static_cast<uint8_t>(argb >> 8),
+		static_cast<uint8_t>(argb), static_cast<uint8_t>(argb >> 24) };
+	for (size_t i = 0; i < target.pixels.size(); i += 4)
+	{
+		std::memcpy(target.pixels.data() + i, color, 4);
+	}
+}
+
+void drawImage(rgbaImage& target, const rgbaImage& sprite, int x, int y)
+{
+	int left = std::max(x, 0);
+	int top = std::max(y, 0);
+	int right = std::min(x + sprite.width, target.width);
+	int bottom = std::min(y + sprite.height, target.height);
+	if (left >= right || top >= bottom)
+	{
+		return;
+	}
+	for (int row = top; row < bottom; row++)
+	{
+		const uint8_t* source = sprite.pixels.data() + (static_cast<size_t>(row - y) * sprite.width + (left - x)) * 4;
+		uint8_t* pixel = target.pixels.data() + (static_cast<size_t>(row) * target.width + left) * 4;
+		if (sprite.opaque)
+		{
+			std::memcpy(pixel, source, static_cast<size_t>(right - left) * 4);
+			continue;
+		}
+		for (int col = left; col < right; col++, source += 4, pixel += 4)
+		{
+			if (source[3] != 0)
+			{
+				blend(pixel, source[0], source[1], source[2], source[3]);
+			}
+		}
+	}
+}
+
+void drawLine(rgbaImage& target, int x1, int y1, int x2, int y2, uint32_t argb, float thickness)
+{
+	// Bresenham with a square pen
+	int pen = std::max(1, static_cast<int>(std::lround(thickness)));
+	int dx = std::abs(x2 - x1);
+	int dy = -std::abs(y2 - y1);
+	int sx = x1 < x2 ? 1 : -1;
+	int sy = y1 < y2 ? 1 : -1;
+	int error = dx + dy;
+	while (true)
+	{
+		fillRect(target, x1 - pen / 2, y1 - pen / 2, pen, pen, argb);
+		if (x1 == x2 && y1 == y2)
+		{
+			break;
+		}
+		int doubled = 2 * error;
+		if (doubled >= dy)
+		{
+			error += dy;
+			x1 += sx;
+		}
+		if (doubled <= dx)
+		{
+			error += dx;
+			y1 += sy;
+		}
+	}
+}
+
+void drawText(rgbaImage& target, const std::wstring& text, int x, int y, float fontSize, uint32_t argb)
+{
+	int scale = std::max(1, static_cast<int>(std::lround(fontSize / GLYPH_PIXELS_PER_EM)));
+	int advance = (GLYPH_WIDTH + 1) * scale;
+	for (wchar_t c : text)
+	{
+		if (const glyph* g = findGlyph(fontCharacter(c)))
+		{
+			for (int row = 0; row < GLYPH_HEIGHT; row++)
+			{
+				for (int col = 0; col < GLYPH_WIDTH; col++)
+				{
+					if (g->rows[row] & (0x10 >> col))
+					{
+						fillRect(target, x + col * scale, y + row * scale, scale, scale, argb);
+					}
+				}
+			}
+		}
+		x += advance;
+	}
+}
+
+void renderFrame(const frameSnapshot& frame, const SpriteCache& sprites, const rgbaImage* background, rgbaImage& target)
+{
+	fillImage(target, 0xFFFFFFFF);
+	if (background)
+	{
+		drawImage(target, *background, 0, 0);
+	}
+	for (const auto& s : frame.sprites)
+	{
+		if (const rgbaImage* image = sprites.find(s.imagePath))
+		{
+			drawImage(target, *image, s.x, s.y);
+		}
+	}
+	for (const auto& l : frame.lines)
+	{
+		drawLine(target, l.x1, l.y1, l.x2, l.y2, l.argb, l.thickness);
+	}
+	for (const auto& t : frame.texts)
+	{
+		drawText(target, t.text, t.x, t.y, t.fontSize, t.argb);
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "FrameSnapshot.h"
+
+// Portable software rasterizer drawing a frameSnapshot into an RGBA buffer, the same
+// picture GdiplusWindow draws on screen. Texts use a built-in 5x7 pixel font (capital
+// letters, digits and a few signs; Polish letters drop their diacritics), scaled to
+// the font size.
+
+struct rgbaImage
+{
+	int width = 0;
+	int height = 0;
+	std::vector<uint8_t> pixels; // Rows top to bottom, 4 bytes per pixel: R, G, B, A
+	bool opaque = false; // Every pixel has alpha 255, so drawing it is a plain copy
+
+	void resize(int width_, int height_);
+	void updateOpacity();
+};
+
+// Decoded sprites by file name. Loaded before rendering starts and read-only afterwards,
+// so any number of threads can render with one cache.
+class SpriteCache
+{
+public:
+	explicit SpriteCache(std::string directory_) : directory(std::move(directory_)) {}
+
+	// Loads directory/name; false with error set if it cannot be read
+	bool load(const std::string& name, std::string& error);
+	// Looks a sprite up by the file name at the end of imagePath, e.g. L".\\zdjencia\\winda.png"
+	const rgbaImage* find(const std::wstring& imagePath) const;
+
+private:
+	std::string directory;
+	std::unordered_map<std::string, rgbaImage> images;
+};
+
+void fillImage(rgbaImage& target, uint32_t argb);
+// Draws sprite with its top left corner at (x, y), blending by its alpha
+void drawImage(rgbaImage& target, const rgbaImage& sprite, int x, int y);
+void drawLine(rgbaImage& target, int x1, int y1, int x2, int y2, uint32_t argb, float thickness);
+void drawText(rgbaImage& target, const std::wstring& text, int x, int y, float fontSize, uint32_t argb);
+
+// Draws a frame the way GdiplusWindow::DrawFrame does: white, the background image,
+// sprites at their natural size, lines, then texts. Sprites missing from the cache are
+// skipped.
+void renderFrame(const frameSnapshot& frame, const SpriteCache& sprites, const rgbaImage* background, rgbaImage& target);
@@ -0,0 +1,165 @@
+#include "RemoteController.h"
+#include <algorithm>
+#include "ControllerProtocol.h"
+
+bool RemoteController::open(const std::string& path, const buildingConfig& config)
+{
+	// Clamped the way the engine clamps them
+	decks = std::clamp(config.decks, 1, MAX_DECKS);
+	int carsPerShaft = std::clamp(config.carsPerShaft, 1, MAX_CARS_PER_SHAFT);
+	if (config.floors > CONTROLLER_MAX_FLOORS || config.cars > CONTROLLER_MAX_CARS
+		|| config.capacity * decks > UINT16_MAX
+		|| STATE_HEADER_BYTES + stateEntrySize(config.floors, config.cars, decks) > CONTROLLER_MAX_MESSAGE)
+	{
+		return fail("Za duzy budynek dla protokolu sterownika");
+	}
+	floors = config.floors;
+	entriesPerMessage = std::min<size_t>(UINT16_MAX,
+		(CONTROLLER_MAX_MESSAGE - STATE_HEADER_BYTES) / stateEntrySize(config.floors, config.cars, decks));
+	if (!link.listen(path))
+	{
+		return fail(link.error());
+	}
+	MessageWriter hello(buffer);
+	hello.put(controllerMessage::hello);
+	hello.put(CONTROLLER_PROTOCOL_VERSION);
+	hello.put(static_cast<uint16_t>(config.floors));
+	hello.put(static_cast<uint16_t>(config.cars));
+	hello.put(static_cast<uint8_t>(decks));
+	hello.put(static_cast<uint8_t>(carsPerShaft));
+	hello.put(static_cast<uint16_t>(config.capacity));
+	hello.put(static_cast<uint8_t>(config.dispatch.callReserve));
+	hello.put(static_cast<uint8_t>(config.dispatch.idleReverse));
+	hello.put(static_cast<float>(config.dispatch.idleThreshold));
+	hello.put(static_cast<float>(config.controllerTick));
+	shafts.clear();
+	for (int car = 0; car < config.cars; car++)
+	{
+		carShaft shaft = shaftOf(config, car);
+		hello.put(static_cast<int16_t>(shaft.minFloor));
+		hello.put(static_cast<int16_t>(shaft.maxFloor));
+		shafts.push_back(shaft);
+	}
+	if (!link.send(buffer) || !link.receive(buffer))
+	{
+		return fail("Sterownik nie odpowiedzial na powitanie");
+	}
+	MessageReader reply(buffer.data(), buffer.size());
+	controllerMessage type{};
+	uint16_t version = 0;
+	if (!reply.get(type) || !reply.get(version) || type != controllerMessage::hello || version != CONTROLLER_PROTOCOL_VERSION)
+	{
+		return fail("Sterownik uzywa innej wersji protokolu");
+	}
+	return true;
+}
+
+void RemoteController::close()
+{
+	if (link.isOpen())
+	{
+		MessageWriter bye(buffer);
+		bye.put(controllerMessage::bye);
+		link.send(buffer);
+		link.close();
+	}
+}
+
+bool RemoteController::decide(std::span<const controllerState* const> states, std::vector<carCommand>& commands)
+{
+	for (size_t first = 0; first < states.size(); first += entriesPerMessage)
+	{
+		if (!exchange(states.subspan(first, std::min(entriesPerMessage, states.size() - first)), first, commands))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool RemoteController::exchange(std::span<const controllerState* const> states, size_t first, std::vector<carCommand>& commands)
+{
+	if (!link.isOpen())
+	{
+		return false;
+	}
+	MessageWriter message(buffer);
+	message.put(controllerMessage::state);
+	message.put(states.front()->tick);
+	message.put(states.front()->time);
+	message.put(static_cast<uint16_t>(states.size()));
+	for (const controllerState* state : states)
+	{
+		message.put(static_cast<uint32_t>(state->building));
+		message.put(state->ticksElapsed);
+		message.putBits(state->waitingUp.data(), floors);
+		message.putBits(state->waitingDown.data(), floors);
+		for (size_t i = 0; i < state->cars.size(); i++)
+		{
+			const carStatus& c = state->cars[i];
+			uint8_t flags = (c.goingUp ? CAR_GOING_UP : 0) | (c.deciding ? CAR_DECIDING : 0) | (c.dwelling ? CAR_DWELLING : 0);
+			message.put(static_cast<int16_t>(c.floor));
+			message.put(static_cast<uint16_t>(c.load));
+			message.put(flags);
+			for (int deck = 0; deck < decks; deck++)
+			{
+				message.putBits(state->stops.data() + (i * decks + deck) * floors, floors);
+			}
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	bool answered = link.send(buffer) && link.receive(buffer);
+	roundTripTotal += std::chrono::steady_clock::now() - start;
+	++roundCount;
+	if (!answered)
+	{
+		link.close();
+		return fail(link.error().empty() ? "Sterownik zamknal polaczenie" : link.error());
+	}
+
+	MessageReader reply(buffer.data(), buffer.size());
+	controllerMessage type{};
+	uint16_t count = 0;
+	if (!reply.get(type) || type != controllerMessage::commands || !reply.get(count))
+	{
+		link.close();
+		return fail("Nieprawidlowa odpowiedz sterownika");
+	}
+	commanded.assign(states.size() * shafts.size(), 0);
+	for (uint16_t i = 0; i < count; i++)
+	{
+		uint16_t entry = 0;
+		uint16_t car = 0;
+		int8_t step = 0;
+		uint8_t goingUp = 0;
+		if (!reply.get(entry) || !reply.get(car) || !reply.get(step) || !reply.get(goingUp))
+		{
+			link.close();
+			return fail("Nieprawidlowa odpowiedz sterownika");
+		}
+		// Only a deciding car may be moved, once, by one floor and within its shaft
+		if (entry >= states.size() || car >= shafts.size() || step < -1 || step > 1
+			|| !states[entry]->cars[car].deciding || commanded[entry * shafts.size() + car]
+			|| states[entry]->cars[car].floor + step < shafts[car].minFloor
+			|| states[entry]->cars[car].floor + step > shafts[car].maxFloor)
+		{
+			link.close();
+			return fail("Nieprawidlowe polecenie sterownika");
+		}
+		commanded[entry * shafts.size() + car] = 1;
+		commands.push_back({ static_cast<int>(first + entry), car, step, goingUp != 0 });
+	}
+	return true;
+}
+
+double RemoteController::meanRoundTrip() const
+{
+	return roundCount ? std::chrono::duration<double>(roundTripTotal).count() / static_cast<double>(roundCount) : 0.0;
+}
+
+bool RemoteController::fail(const std::string& what)
+{
+	lastError = what;
+	return false;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Building.h"
+#include "ControllerLink.h"
+#include "DispatchController.h"
+
+// DispatchController talking to an external process over ControllerLink. Every decide()
+// is one lock-step round trip: one state message with all listed buildings, one commands
+// message back; a batch larger than CONTROLLER_MAX_MESSAGE takes one round trip per
+// message. The time spent waiting for the answers is measured.
+
+class RemoteController final : public DispatchController
+{
+public:
+	// Waits for a controller to connect on path and exchanges hello messages
+	bool open(const std::string& path, const buildingConfig& config);
+	// Tells the controller the simulation is over
+	void close();
+
+	bool decide(std::span<const controllerState* const> states, std::vector<carCommand>& commands) override;
+
+	uint64_t rounds() const { return roundCount; }
+	double meanRoundTrip() const; // Seconds per round trip
+	const std::string& error() const { return lastError; }
+
+private:
+	ControllerLink link;
+	std::vector<uint8_t> buffer;
+	int floors = 0;
+	int decks = 1;
+	std::vector<carShaft> shafts; // [car] range the car's position may take
+	std::vector<uint8_t> commanded; // [entry * cars + car] 1 once the reply names that car
+	size_t entriesPerMessage = 1;
+	uint64_t roundCount = 0;
+	std::chrono::steady_clock::duration roundTripTotal{};
+	std::string lastError;
+
+	// One round trip for states, whose entries start at position first of the batch
+	bool exchange(std::span<const controllerState* const> states, size_t first, std::vector<carCommand>& commands);
+	bool fail(const std::string& what);
+};
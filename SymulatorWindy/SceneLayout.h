@@ -0,0 +1,31 @@
+#pragma once
+#include <array>
+
+// Screen layout of the building picture (zdjencia/sybwindy.png), shared by the window
+// and the offscreen renderer. Uses only standard types, no Windows headers.
+
+struct screenPoint
+{
+	int X;
+	int Y;
+};
+
+constexpr int SCENE_WIDTH = 800;
+constexpr int SCENE_HEIGHT = 600;
+
+constexpr std::array<screenPoint, 5> FLOOR_EXITS =
+{
+	screenPoint{0, 482},    // GROUND_FLOOR_EXIT
+	screenPoint{767, 382},  // FIRST_FLOOR_EXIT
+	screenPoint{0, 302},    // SECOND_FLOOR_EXIT
+	screenPoint{767, 158},  // THIRD_FLOOR_EXIT
+	screenPoint{0, 118}     // FOURTH_FLOOR_EXIT
+};
+constexpr int ELEVATOR_START_X = 298;
+constexpr int ELEVATOR_Y_OFFSET = 64; // Offset for the elevator sprite Y position
+constexpr int SPACING = 24; // Spacing between passengers in the elevator
+constexpr int OFFSET_BASE = 24; // Base offset for repositioning passengers on the floor
+constexpr int LEFT_X = 253; // X position for left side of the floor
+constexpr int RIGHT_X = 500; // X position for right side of the floor
+constexpr screenPoint WEIGHT_TEXT = { 300, 25 }; // Position for the text displaying passenger weight
+constexpr int PASSENGER_WEIGHT = 70; // Kilograms per passenger in the weight text
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+
+// Types shared by the elevator logic that do not depend on the Windows GUI.
+
+constexpr int FLOOR_COUNT = 5; // Number of floors in the building
+constexpr int MAX_CAPACITY = 8; // Maximum number of passengers in the elevator
+constexpr int IDLE_THRESHOLD = 5; // Time in seconds after which the elevator returns to ground floor if idle
+constexpr int CALL_RESERVE = 1; // Free places the elevator keeps before it stops answering floor calls
+
+// Tunable constants of the dispatch rules. The defaults reproduce the original behaviour.
+struct dispatchParams
+{
+	double idleThreshold = IDLE_THRESHOLD; // Seconds an empty car waits before it returns to the ground floor
+	int callReserve = CALL_RESERVE; // Calls on other floors are served only while load + callReserve < capacity
+	bool idleReverse = true; // An idle car flips its direction while it waits
+};
+
+struct passenger
+{
+	int startFloor;
+	int destination;
+	bool isInElevator = false;
+	size_t passengerId;
+	double arrivalTime = 0.0; // Simulation time (s) at which the passenger called the elevator
+	double boardTime = -1.0; // Simulation time (s) of boarding, -1 while waiting
+	double alightTime = -1.0; // Simulation time (s) of leaving the car, -1 while waiting or riding
+	int carId = -1; // Car the passenger boarded
+	int deck = 0; // Deck of the car, 0 = lowest
+	int queueSlot = -1; // Position in the floor queue the passenger was last moved to
+};
+
+// A call submitted from the UI (or any other input source) to the simulation thread.
+struct callRequest
+{
+	int startFloor;
+	int destination;
+	size_t spriteId;
+};
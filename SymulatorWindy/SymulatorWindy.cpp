@@ -11,7 +11,10 @@ int main()
     GdiplusWindow temp(hInst, L"Symulator windy", 800, 600, L".\\zdjencia\\sybwindy.png");
     elevatorWindow win(temp);
 
-    return win.runMessageLoop();
+    Trace::setThreadName("simulation");
+    int result = win.runMessageLoop();
+    Trace::exportChromeTrace("slad.json"); // No-op unless built with SYMULATOR_TRACE
+    return result;
 }
 
 elevatorWindow::elevatorWindow(GdiplusWindow& window_)
@@ -126,5 +129,9 @@ int elevatorWindow::runMessageLoop()
 
 void elevatorWindow::onButtonClick(int initialFloor, int destination, int x, int y)
 {
-    elevatorLogic->addPassenger(initialFloor, destination, window->AddSprite(L".\\zdjencia\\" + std::to_wstring(destination) + L"ludziknonbasic.png", x, y));
+    size_t spriteId = window->AddSprite(L".\\zdjencia\\" + std::to_wstring(destination) + L"ludziknonbasic.png", x, y);
+    if (!elevatorLogic->submitCall(initialFloor, destination, spriteId))
+    {
+        window->RemoveSprite(spriteId); // Call queue is full, drop the call
+    }
 }
@@ -0,0 +1,277 @@
+#include "Timelapse.h"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Raster.h"
+#include "SceneLayout.h"
+#include "Trace.h"
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace
+{
+	constexpr screenPoint CLOCK_TEXT = { 310, 565 }; // Simulated time of day, below the ground floor
+	constexpr uint32_t TEXT_COLOR = 0xFF000000;
+	constexpr float TEXT_SIZE = 16.0f;
+
+	struct frameJob
+	{
+		uint64_t index = 0;
+		frameSnapshot frame;
+	};
+
+	std::wstring passengerSprite(int destination)
+	{
+		return std::to_wstring(destination) + L"ludziknonbasic.png";
+	}
+
+	// The window's picture of the building: the same sprites at the same places as
+	// ElevatorLogic puts them once all animations have finished
+	void composeScene(const buildingView& view, frameSnapshot& frame)
+	{
+		frame.sprites.clear();
+		frame.lines.clear();
+		frame.texts.clear();
+		size_t spriteId = 0;
+		const carView& car = view.cars.front();
+		frame.sprites.push_back({ spriteId++, L"winda.png", ELEVATOR_START_X, FLOOR_EXITS[car.floor].Y + ELEVATOR_Y_OFFSET, 0, 0 });
+		for (size_t i = 0; i < car.riders.size(); i++)
+		{
+			frame.sprites.push_back({ spriteId++, passengerSprite(car.riders[i]),
+				ELEVATOR_START_X + SPACING * static_cast<int>(i), FLOOR_EXITS[car.floor].Y, 0, 0 });
+		}
+		for (size_t floor = 0; floor < view.waiting.size(); floor++)
+		{
+			const auto& waiting = view.waiting[floor];
+			for (size_t slot = 0; slot < waiting.size(); slot++)
+			{
+				int offset = OFFSET_BASE * static_cast<int>(slot);
+				int x = floor % 2 == 0 ? LEFT_X - offset : RIGHT_X + offset;
+				if (x < -SPACING || x > SCENE_WIDTH)
+				{
+					break; // The rest of the queue is off screen
+				}
+				frame.sprites.push_back({ spriteId++, passengerSprite(waiting[slot]), x, FLOOR_EXITS[floor].Y, 0, 0 });
+			}
+		}
+
+		frame.texts.push_back({ L"Waga pasa\u017Cer\u00F3w: " + std::to_wstring(car.riders.size() * PASSENGER_WEIGHT) + L"kg",
+			WEIGHT_TEXT.X, WEIGHT_TEXT.Y, L"Arial", TEXT_SIZE, TEXT_COLOR });
+		long long seconds = std::llround(view.time);
+		wchar_t clock[32];
+		std::swprintf(clock, 32, L"Dzie\u0144 %lld, %02lld:%02lld", seconds / 86400 + 1, seconds / 3600 % 24, seconds / 60 % 60);
+		frame.texts.push_back({ clock, CLOCK_TEXT.X, CLOCK_TEXT.Y, L"Arial", TEXT_SIZE, TEXT_COLOR });
+	}
+
+	bool writePpm(const std::string& path, const rgbaImage& image, std::vector<uint8_t>& rgb)
+	{
+		rgb.resize(static_cast<size_t>(image.width) * image.height * 3);
+		for (size_t i = 0, j = 0; i < image.pixels.size(); i += 4, j += 3)
+		{
+			rgb[j] = image.pixels[i];
+			rgb[j + 1] = image.pixels[i + 1];
+			rgb[j + 2] = image.pixels[i + 2];
+		}
+		std::ofstream file(path, std::ios::binary);
+		file << "P6\n" << image.width << " " << image.height << "\n255\n";
+		file.write(reinterpret_cast<const char*>(rgb.data()), static_cast<std::streamsize>(rgb.size()));
+		return static_cast<bool>(file);
+	}
+
+	std::string framePath(const std::string& directory, uint64_t index)
+	{
+		char name[32];
+		std::snprintf(name, sizeof(name), "klatka_%06llu.ppm", static_cast<unsigned long long>(index));
+		return (std::filesystem::path(directory) / name).string();
+	}
+}
+
+Timelapse::Timelapse(const timelapseConfig& config_) : cfg(config_)
+{
+	if (cfg.workers <= 0)
+	{
+		cfg.workers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+}
+
+timelapseResult Timelapse::run()
+{
+	timelapseResult result;
+	result.workers = cfg.workers;
+	const buildingConfig& b = cfg.building;
+	if (b.floors != static_cast<int>(FLOOR_EXITS.size()) || b.cars != 1 || b.decks != 1 || b.carsPerShaft != 1)
+	{
+		result.error = "Animacja wymaga budynku z oknem: " + std::to_string(FLOOR_EXITS.size()) + " pieter i jednej windy";
+		return result;
+	}
+	if (cfg.interval <= 0.0 || cfg.output.empty())
+	{
+		result.error = "Nieprawidlowe parametry animacji";
+		return result;
+	}
+
+	// All sprites are decoded up front; the workers only read the cache
+	SpriteCache sprites(cfg.assets);
+	std::vector<std::string> names = { "sybwindy.png", "winda.png" };
+	for (int floor = 0; floor < b.floors; floor++)
+	{
+		names.push_back(std::to_string(floor) + "ludziknonbasic.png");
+	}
+	for (const auto& name : names)
+	{
+		if (!sprites.load(name, result.error))
+		{
+			return result;
+		}
+	}
+	const rgbaImage* background = sprites.find(L"sybwindy.png");
+
+	bool toPipe = cfg.output == "-";
+	if (toPipe)
+	{
+#ifdef _WIN32
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+	}
+	else
+	{
+		std::error_code error;
+		std::filesystem::create_directories(cfg.output, error);
+		if (error)
+		{
+			result.error = "Nie mozna utworzyc katalogu " + cfg.output;
+			return result;
+		}
+	}
+
+	BuildingPtr building = makeBuilding(cfg.building, std::pmr::get_default_resource(), cfg.forceDynamic);
+	uint64_t frameCount = static_cast<uint64_t>(std::floor(cfg.duration / cfg.interval)) + 1;
+	size_t maxInFlight = static_cast<size_t>(cfg.workers) * TIMELAPSE_FRAMES_PER_WORKER;
+
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::deque<frameJob> jobs; // Composed frames waiting for a worker
+	size_t inFlight = 0; // Frames queued or being rendered
+	uint64_t nextToWrite = 0; // Raw output must stay in frame order
+	uint64_t written = 0;
+	bool finished = false;
+	bool failed = false;
+
+	auto work = [&](int index)
+	{
+		Trace::setThreadName("render " + std::to_string(index));
+		rgbaImage image;
+		image.resize(SCENE_WIDTH, SCENE_HEIGHT);
+		std::vector<uint8_t> rgb;
+		while (true)
+		{
+			frameJob job;
+			{
+				std::unique_lock lock(mutex);
+				changed.wait(lock, [&] { return !jobs.empty() || finished || failed; });
+				if (jobs.empty() || failed)
+				{
+					return;
+				}
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+			{
+				TRACE_SCOPE_VALUE("renderFrame", job.index);
+				renderFrame(job.frame, sprites, background, image);
+			}
+
+			bool ok = true;
+			if (toPipe)
+			{
+				{
+					std::unique_lock lock(mutex);
+					changed.wait(lock, [&] { return nextToWrite == job.index || failed; });
+					if (failed)
+					{
+						return;
+					}
+				}
+				// Only the worker holding the next frame writes, so no lock is needed here
+				ok = std::fwrite(image.pixels.data(), 1, image.pixels.size(), stdout) == image.pixels.size();
+			}
+			else
+			{
+				TRACE_SCOPE_VALUE("writeFrame", job.index);
+				ok = writePpm(framePath(cfg.output, job.index), image, rgb);
+			}
+
+			{
+				std::lock_guard lock(mutex);
+				--inFlight;
+				++nextToWrite;
+				written += ok ? 1 : 0;
+				if (!ok && !failed)
+				{
+					failed = true;
+					result.error = toPipe ? "Blad zapisu na standardowe wyjscie" : "Blad zapisu do " + framePath(cfg.output, job.index);
+				}
+			}
+			changed.notify_all();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(cfg.workers);
+	for (int i = 0; i < cfg.workers; i++)
+	{
+		threads.emplace_back(work, i);
+	}
+
+	buildingView view;
+	for (uint64_t k = 0; k < frameCount; k++)
+	{
+		frameJob job;
+		job.index = k;
+		{
+			TRACE_SCOPE_VALUE("composeFrame", k);
+			building->advanceTo(static_cast<double>(k) * cfg.interval);
+			building->view(view);
+			composeScene(view, job.frame);
+			job.frame.sequence = k;
+		}
+		std::unique_lock lock(mutex);
+		changed.wait(lock, [&] { return inFlight < maxInFlight || failed; });
+		if (failed)
+		{
+			break;
+		}
+		jobs.push_back(std::move(job));
+		++inFlight;
+		lock.unlock();
+		changed.notify_all();
+	}
+	{
+		std::lock_guard lock(mutex);
+		finished = true;
+	}
+	changed.notify_all();
+	for (auto& t : threads)
+	{
+		t.join();
+	}
+	if (toPipe)
+	{
+		std::fflush(stdout);
+	}
+
+	building->advanceTo(cfg.duration);
+	result.metrics = building->metrics();
+	result.frames = written;
+	result.ok = !failed;
+	return result;
+}
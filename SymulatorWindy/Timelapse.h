@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "Building.h"
+
+// Offscreen export of one building as a timelapse. The simulation thread advances the
+// building in fixed steps of simulated time and turns every step into a frameSnapshot
+// of the window's scene (SceneLayout.h); worker threads render the snapshots with the
+// software rasterizer and write them out. At most TIMELAPSE_FRAMES_PER_WORKER frames per
+// worker are queued or in flight, so memory stays bounded however long the run is.
+//
+// Frames go either to numbered PPM files in a directory or, in order, as raw 8-bit RGBA
+// to standard output, e.g. for
+//   ffmpeg -f rawvideo -pixel_format rgba -video_size 800x600 -framerate 30 -i - doba.mp4
+// The scene is the window's picture of a five-floor building with one car, so only that
+// configuration can be exported.
+
+constexpr int TIMELAPSE_FRAMES_PER_WORKER = 2; // Frames queued or being rendered per worker
+
+struct timelapseConfig
+{
+	buildingConfig building;
+	double duration = 24.0 * 3600.0; // Simulated time in seconds
+	double interval = 60.0; // Simulated seconds between frames
+	int workers = 0; // 0 = one worker per hardware thread
+	std::string assets = "zdjencia"; // Directory with the window's PNG sprites
+	std::string output; // Directory for numbered PPM files, or "-" for raw RGBA on standard output
+	bool forceDynamic = false;
+};
+
+struct timelapseResult
+{
+	bool ok = false;
+	std::string error;
+	uint64_t frames = 0; // Frames written
+	int workers = 0;
+	buildingMetrics metrics;
+};
+
+class Timelapse
+{
+public:
+	explicit Timelapse(const timelapseConfig& config_);
+
+	timelapseResult run();
+
+private:
+	timelapseConfig cfg;
+};
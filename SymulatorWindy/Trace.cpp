@@ -0,0 +1,136 @@
+#include "Trace.h"
+
+#ifdef SYMULATOR_TRACE
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+	struct traceEvent
+	{
+		const char* name;
+		int64_t start;
+		int64_t duration;
+		long long value;
+	};
+
+	// Written only by its own thread; the exporter reads up to count
+	struct threadBuffer
+	{
+		std::vector<traceEvent> events = std::vector<traceEvent>(TRACE_BUFFER_EVENTS);
+		std::atomic<size_t> count{ 0 };
+		std::atomic<size_t> dropped{ 0 };
+		int threadId = 0;
+		std::string threadName;
+	};
+
+	std::mutex registryMutex; // Only taken when a thread records its first span
+	std::vector<std::unique_ptr<threadBuffer>> registry;
+
+	threadBuffer& localBuffer()
+	{
+		thread_local threadBuffer* buffer = nullptr;
+		if (!buffer)
+		{
+			std::lock_guard<std::mutex> lock(registryMutex);
+			registry.push_back(std::make_unique<threadBuffer>());
+			buffer = registry.back().get();
+			buffer->threadId = static_cast<int>(registry.size());
+		}
+		return *buffer;
+	}
+
+	void writeJsonString(std::ofstream& out, const std::string& text)
+	{
+		out << '"';
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\') out << '\\';
+			out << c;
+		}
+		out << '"';
+	}
+}
+
+int64_t Trace::now()
+{
+	static const auto origin = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void Trace::record(const char* name, int64_t start, int64_t end, long long value)
+{
+	threadBuffer& buffer = localBuffer();
+	size_t index = buffer.count.load(std::memory_order_relaxed);
+	if (index >= buffer.events.size())
+	{
+		buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	buffer.events[index] = { name, start, end - start, value };
+	buffer.count.store(index + 1, std::memory_order_release);
+}
+
+void Trace::setThreadName(const std::string& name)
+{
+	threadBuffer& buffer = localBuffer();
+	std::lock_guard<std::mutex> lock(registryMutex);
+	buffer.threadName = name;
+}
+
+bool Trace::exportChromeTrace(const std::string& path)
+{
+	std::ofstream out(path);
+	if (!out)
+	{
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(registryMutex);
+	out.setf(std::ios::fixed);
+	out.precision(3);
+	out << "{\"traceEvents\":[";
+	bool first = true;
+	size_t dropped = 0;
+	for (const auto& buffer : registry)
+	{
+		if (!buffer->threadName.empty())
+		{
+			out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"args\":{\"name\":";
+			writeJsonString(out, buffer->threadName);
+			out << "}}";
+			first = false;
+		}
+		size_t count = buffer->count.load(std::memory_order_acquire);
+		for (size_t i = 0; i < count; i++)
+		{
+			const traceEvent& e = buffer->events[i];
+			out << (first ? "" : ",") << "\n{\"name\":";
+			writeJsonString(out, e.name);
+			out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+				<< ",\"ts\":" << static_cast<double>(e.start) / 1000.0
+				<< ",\"dur\":" << static_cast<double>(e.duration) / 1000.0;
+			if (e.value >= 0)
+			{
+				out << ",\"args\":{\"value\":" << e.value << "}";
+			}
+			out << "}";
+			first = false;
+		}
+		dropped += buffer->dropped.load(std::memory_order_relaxed);
+	}
+	out << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedSpans\":" << dropped << "}}\n";
+	return static_cast<bool>(out);
+}
+
+#else
+
+int64_t Trace::now() { return 0; }
+void Trace::record(const char*, int64_t, int64_t, long long) {}
+void Trace::setThreadName(const std::string&) {}
+bool Trace::exportChromeTrace(const std::string&) { return false; }
+
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Scoped trace spans exported as Chrome/Perfetto trace JSON (chrome://tracing, ui.perfetto.dev).
+// Spans are only compiled in when SYMULATOR_TRACE is defined (Debug builds, or the
+// SYMULATOR_TRACE CMake option); otherwise TRACE_SCOPE expands to nothing.
+// Every thread writes to its own fixed-size buffer without locking; spans that do not
+// fit are dropped and counted.
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef SYMULATOR_TRACE
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define TRACE_SCOPE_VALUE(name, value) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name, static_cast<long long>(value))
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_SCOPE_VALUE(name, value) ((void)0)
+#endif
+
+constexpr size_t TRACE_BUFFER_EVENTS = 1 << 18; // Spans stored per thread
+
+class Trace
+{
+public:
+	static constexpr bool enabled =
+#ifdef SYMULATOR_TRACE
+		true;
+#else
+		false;
+#endif
+
+	// Nanoseconds since the first call, from a monotonic clock
+	static int64_t now();
+	// name must be a string literal (only the pointer is stored)
+	static void record(const char* name, int64_t start, int64_t end, long long value);
+	// Names the calling thread in the exported trace
+	static void setThreadName(const std::string& name);
+	// Writes all recorded spans; returns false if tracing is compiled out or the file cannot be written
+	static bool exportChromeTrace(const std::string& path);
+};
+
+#ifdef SYMULATOR_TRACE
+class TraceScope
+{
+public:
+	explicit TraceScope(const char* name_, long long value_ = -1) : name(name_), value(value_), start(Trace::now()) {}
+	~TraceScope() { Trace::record(name, start, Trace::now(), value); }
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+	const char* name;
+	long long value;
+	int64_t start;
+};
+#endif
@@ -0,0 +1,133 @@
+#include "Traffic.h"
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	constexpr double PEAK_RATE_FACTOR = 3.0; // Highest office-day rate relative to arrivalsPerHour
+	constexpr double CANTEEN_SHARE = 0.8; // Fraction of lunchtime passengers going to or from the canteen
+
+	enum class officePeriod
+	{
+		night, day, morningPeak, lunchOut, lunchBack, eveningPeak,
+	};
+
+	officePeriod officePeriodAt(double time)
+	{
+		double hour = std::fmod(time, 24.0 * 3600.0) / 3600.0;
+		if (hour < 6.0 || hour >= 22.0) return officePeriod::night;
+		if (hour >= 7.5 && hour < 9.5) return officePeriod::morningPeak;
+		if (hour >= 12.0 && hour < 12.5) return officePeriod::lunchOut;
+		if (hour >= 12.5 && hour < 13.5) return officePeriod::lunchBack;
+		if (hour >= 16.5 && hour < 18.5) return officePeriod::eveningPeak;
+		return officePeriod::day;
+	}
+
+	double officeRateFactor(officePeriod period)
+	{
+		switch (period)
+		{
+		case officePeriod::night: return 0.2;
+		case officePeriod::morningPeak:
+		case officePeriod::eveningPeak: return PEAK_RATE_FACTOR;
+		case officePeriod::lunchOut:
+		case officePeriod::lunchBack: return 2.0;
+		default: return 1.0;
+		}
+	}
+}
+
+TrafficGenerator::TrafficGenerator(const buildingConfig& config)
+	: floors(config.floors), lobbyShare(config.lobbyShare), pattern(config.pattern), random(config.seed),
+	interArrival(config.arrivalsPerHour > 0.0
+		? config.arrivalsPerHour / 3600.0 * (config.pattern == trafficPattern::officeDay ? PEAK_RATE_FACTOR : 1.0)
+		: 1.0),
+	next(0.0)
+{
+	if (config.arrivalsPerHour > 0.0)
+	{
+		scheduleNext();
+	}
+	else
+	{
+		next = std::numeric_limits<double>::infinity();
+	}
+}
+
+trafficCall TrafficGenerator::pop()
+{
+	trafficCall call = pattern == trafficPattern::officeDay ? officeCall(next) : mixedCall(lobbyShare, lobbyShare);
+	scheduleNext();
+	return call;
+}
+
+// fromLobby of the passengers start on the ground floor; of the others, toLobby go down to it
+trafficCall TrafficGenerator::mixedCall(double fromLobby, double toLobby)
+{
+	std::uniform_real_distribution<double> chance(0.0, 1.0);
+	std::uniform_int_distribution<int> upperFloor(1, floors - 1);
+	int startFloor = chance(random) < fromLobby ? 0 : upperFloor(random);
+	int destination = 0;
+	if (startFloor == 0)
+	{
+		destination = upperFloor(random);
+	}
+	else if (chance(random) >= toLobby)
+	{
+		// Any other floor, picked uniformly
+		std::uniform_int_distribution<int> otherFloor(0, floors - 2);
+		destination = otherFloor(random);
+		if (destination >= startFloor)
+		{
+			++destination;
+		}
+	}
+	return { startFloor, destination };
+}
+
+trafficCall TrafficGenerator::officeCall(double time)
+{
+	std::uniform_real_distribution<double> chance(0.0, 1.0);
+	int canteen = floors / 2;
+	switch (officePeriodAt(time))
+	{
+	case officePeriod::morningPeak:
+		return mixedCall(0.9, lobbyShare);
+	case officePeriod::eveningPeak:
+		return mixedCall(0.05, 0.9);
+	case officePeriod::lunchOut:
+	case officePeriod::lunchBack:
+		if (floors > 2 && chance(random) < CANTEEN_SHARE)
+		{
+			// Between the canteen and any other floor
+			std::uniform_int_distribution<int> otherFloor(0, floors - 2);
+			int other = otherFloor(random);
+			if (other >= canteen)
+			{
+				++other;
+			}
+			if (officePeriodAt(time) == officePeriod::lunchOut)
+			{
+				return { other, canteen };
+			}
+			return { canteen, other };
+		}
+		return mixedCall(lobbyShare, lobbyShare);
+	default:
+		return mixedCall(lobbyShare, lobbyShare);
+	}
+}
+
+void TrafficGenerator::scheduleNext()
+{
+	next += interArrival(random);
+	if (pattern == trafficPattern::officeDay)
+	{
+		// Thinning: candidates come at the peak rate and are kept in proportion to the current rate
+		std::uniform_real_distribution<double> chance(0.0, PEAK_RATE_FACTOR);
+		while (chance(random) >= officeRateFactor(officePeriodAt(next)))
+		{
+			next += interArrival(random);
+		}
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <random>
+#include "Building.h"
+
+struct trafficCall
+{
+	int startFloor;
+	int destination;
+};
+
+// Seeded Poisson stream of passenger calls. Half of the passengers (lobbyShare) start on
+// the ground floor; the rest start on an upper floor and go down to the lobby or to
+// any other floor. With trafficPattern::officeDay the rate and the mix follow the time of
+// day (arrivalsPerHour is the daytime base rate) and arrivals are drawn by thinning.
+class TrafficGenerator
+{
+public:
+	explicit TrafficGenerator(const buildingConfig& config);
+
+	double nextArrival() const { return next; }
+	// Returns the call arriving at nextArrival() and schedules the following one
+	trafficCall pop();
+
+private:
+	int floors;
+	double lobbyShare;
+	trafficPattern pattern;
+	std::mt19937 random;
+	std::exponential_distribution<double> interArrival;
+	double next;
+
+	trafficCall mixedCall(double fromLobby, double toLobby);
+	trafficCall officeCall(double time);
+	void scheduleNext();
+};
@@ -0,0 +1,196 @@
+#include "Tuner.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory_resource>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include "Trace.h"
+
+namespace
+{
+	constexpr double MAX_IDLE_THRESHOLD = 60.0; // Longest idle threshold tried, in seconds
+	constexpr int MIN_TUNED_CAPACITY = 2; // Smallest usable capacity tried
+	constexpr int SAMPLED_DIMENSIONS = 4; // idleThreshold, callReserve, idleReverse, capacity
+
+	// Seed of simulation number index; the same for every candidate
+	unsigned simulationSeed(unsigned seed, int index)
+	{
+		return seed * 1000003u + static_cast<unsigned>(index);
+	}
+
+	int pickInt(double u, int low, int high)
+	{
+		return std::min(high, low + static_cast<int>(u * (high - low + 1)));
+	}
+}
+
+Tuner::Tuner(const tuningConfig& config_) : cfg(config_)
+{
+	if (cfg.workers <= 0)
+	{
+		cfg.workers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+	cfg.candidates = std::max(1, cfg.candidates);
+	cfg.firstSimulations = std::max(1, cfg.firstSimulations);
+	cfg.building.capacity = std::max(MIN_TUNED_CAPACITY, cfg.building.capacity);
+}
+
+double Tuner::score(const buildingMetrics& metrics, tuningObjective objective)
+{
+	switch (objective)
+	{
+	case tuningObjective::meanWait:
+	{
+		size_t waited = metrics.boarded + metrics.unserved;
+		return waited ? metrics.totalWait / waited : 0.0;
+	}
+	case tuningObjective::energyPerPassenger:
+		return metrics.delivered ? metrics.energy / metrics.delivered : metrics.energy;
+	default:
+		return waitPercentile(metrics, 0.95);
+	}
+}
+
+tuningResult Tuner::run()
+{
+	std::vector<tuningCandidate> candidates = sampleCandidates();
+	std::vector<tuningCandidate*> alive;
+	for (auto& c : candidates)
+	{
+		alive.push_back(&c);
+	}
+
+	tuningResult result;
+	int simulations = 0; // Simulations done by every remaining candidate
+	int roundSize = cfg.firstSimulations;
+	while (true)
+	{
+		TRACE_SCOPE_VALUE("tuningRound", result.rounds);
+		evaluate(alive, simulations, simulations + roundSize);
+		result.simulations += static_cast<int>(alive.size()) * roundSize;
+		simulations += roundSize;
+		++result.rounds;
+		for (auto* c : alive)
+		{
+			c->score = score(c->metrics, cfg.objective);
+		}
+		// Candidates keep their sampling order on ties, so the baseline wins a tie.
+		// Percentiles beyond the wait histogram are all infinite; those candidates are
+		// ranked by their mean wait instead.
+		std::stable_sort(alive.begin(), alive.end(),
+			[](const tuningCandidate* a, const tuningCandidate* b)
+			{
+				if (std::isinf(a->score) && std::isinf(b->score))
+				{
+					return score(a->metrics, tuningObjective::meanWait) < score(b->metrics, tuningObjective::meanWait);
+				}
+				return a->score < b->score;
+			});
+		if (alive.size() == 1)
+		{
+			break;
+		}
+		alive.resize((alive.size() + 1) / 2);
+		roundSize = simulations;
+	}
+	result.best = *alive.front();
+
+	// Bring the baseline up to the same simulations as the winner for a fair comparison
+	tuningCandidate& baseline = candidates.front();
+	if (baseline.simulations < simulations)
+	{
+		std::vector<tuningCandidate*> single{ &baseline };
+		evaluate(single, baseline.simulations, simulations);
+		result.simulations += simulations - baseline.simulations;
+		baseline.score = score(baseline.metrics, cfg.objective);
+	}
+	result.baseline = baseline;
+	return result;
+}
+
+std::vector<tuningCandidate> Tuner::sampleCandidates() const
+{
+	std::vector<tuningCandidate> candidates(cfg.candidates);
+	candidates[0].capacity = cfg.building.capacity; // Candidate 0 keeps the defaults
+
+	// Latin hypercube: every dimension is split into one stratum per sampled candidate,
+	// and each stratum is used exactly once
+	int sampled = cfg.candidates - 1;
+	std::mt19937 random(cfg.seed);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	std::vector<std::vector<int>> strata(SAMPLED_DIMENSIONS, std::vector<int>(sampled));
+	for (auto& order : strata)
+	{
+		std::iota(order.begin(), order.end(), 0);
+		std::shuffle(order.begin(), order.end(), random);
+	}
+	for (int i = 0; i < sampled; i++)
+	{
+		double u[SAMPLED_DIMENSIONS];
+		for (int d = 0; d < SAMPLED_DIMENSIONS; d++)
+		{
+			u[d] = (strata[d][i] + unit(random)) / sampled;
+		}
+		tuningCandidate& c = candidates[i + 1];
+		c.dispatch.idleThreshold = u[0] * MAX_IDLE_THRESHOLD;
+		c.capacity = pickInt(u[3], MIN_TUNED_CAPACITY, cfg.building.capacity);
+		c.dispatch.callReserve = pickInt(u[1], 0, c.capacity - 1);
+		c.dispatch.idleReverse = u[2] >= 0.5;
+	}
+	return candidates;
+}
+
+void Tuner::evaluate(std::vector<tuningCandidate*>& candidates, int from, int to) const
+{
+	int perCandidate = to - from;
+	size_t jobs = candidates.size() * static_cast<size_t>(perCandidate);
+	std::vector<buildingMetrics> results(jobs);
+	std::atomic<size_t> nextJob{ 0 };
+
+	auto worker = [&](int index)
+		{
+			Trace::setThreadName("tuner " + std::to_string(index));
+			std::pmr::unsynchronized_pool_resource arena;
+			for (size_t job = nextJob.fetch_add(1); job < jobs; job = nextJob.fetch_add(1))
+			{
+				const tuningCandidate& c = *candidates[job / perCandidate];
+				int simulation = from + static_cast<int>(job % perCandidate);
+				TRACE_SCOPE_VALUE("simulation", simulation);
+				buildingConfig building = cfg.building;
+				building.capacity = c.capacity;
+				building.dispatch = c.dispatch;
+				building.seed = simulationSeed(cfg.seed, simulation);
+				building.journeyLog = nullptr;
+				BuildingPtr b = makeBuilding(building, &arena, true);
+				b->advanceTo(cfg.duration);
+				results[job] = b->metrics();
+				b->addUnserved(results[job]);
+			}
+		};
+
+	int workerCount = static_cast<int>(std::min<size_t>(cfg.workers, jobs));
+	std::vector<std::thread> threads;
+	threads.reserve(workerCount);
+	for (int i = 0; i < workerCount; i++)
+	{
+		threads.emplace_back(worker, i);
+	}
+	for (auto& t : threads)
+	{
+		t.join();
+	}
+
+	// Summed in job order, so the totals do not depend on the number of workers
+	for (size_t job = 0; job < jobs; job++)
+	{
+		tuningCandidate& c = *candidates[job / perCandidate];
+		addMetrics(c.metrics, results[job]);
+	}
+	for (auto* c : candidates)
+	{
+		c->simulations += perCandidate;
+	}
+}
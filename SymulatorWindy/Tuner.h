@@ -0,0 +1,69 @@
+#pragma once
+#include <vector>
+#include "Building.h"
+
+// Automatic tuning of the dispatch constants (dispatchParams and the usable car
+// capacity) for one building profile.
+//
+// Candidates are drawn by Latin hypercube sampling, with the current defaults always
+// included, and narrowed down by successive halving: every round evaluates the remaining
+// candidates on twice as many simulations as the round before and keeps the better half.
+// All candidates are run with the same seeds (common random numbers), so their
+// differences come from the parameters and not from the random traffic. The
+// simulations of a round are spread over worker threads.
+//
+// Every candidate runs on ElevatorEngine, whatever its capacity, so all are scored by the
+// same rules. Passengers still waiting when a simulation ends count towards the wait
+// objectives with the time they have waited so far.
+
+enum class tuningObjective
+{
+	p95Wait, // 95th percentile of the wait on the floor
+	meanWait,
+	energyPerPassenger,
+};
+
+struct tuningConfig
+{
+	buildingConfig building; // Profile to tune for; its capacity is the largest one tried
+	double duration = 8.0 * 3600.0; // Simulated time of one evaluation in seconds
+	int candidates = 32;
+	int firstSimulations = 4; // Simulations per candidate in the first round
+	int workers = 0; // 0 = one worker per hardware thread
+	unsigned seed = 1;
+	tuningObjective objective = tuningObjective::p95Wait;
+};
+
+struct tuningCandidate
+{
+	dispatchParams dispatch;
+	int capacity = MAX_CAPACITY;
+	buildingMetrics metrics; // Sum over all simulations of this candidate
+	int simulations = 0;
+	double score = 0.0; // Objective value, lower is better
+};
+
+struct tuningResult
+{
+	tuningCandidate best;
+	tuningCandidate baseline; // Default parameters, evaluated on the same seeds as best
+	int rounds = 0;
+	int simulations = 0; // Total over all candidates
+};
+
+class Tuner
+{
+public:
+	explicit Tuner(const tuningConfig& config_);
+
+	tuningResult run();
+
+	static double score(const buildingMetrics& metrics, tuningObjective objective);
+
+private:
+	tuningConfig cfg;
+
+	std::vector<tuningCandidate> sampleCandidates() const;
+	// Runs every listed candidate on the simulations [from, to) and adds up the results
+	void evaluate(std::vector<tuningCandidate*>& candidates, int from, int to) const;
+};
@@ -0,0 +1,122 @@
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "CallQueue.h"
+#include "TestCheck.h"
+
+namespace
+{
+	constexpr int PRODUCERS = 4;
+	constexpr uint32_t PUSHES_PER_PRODUCER = 200000;
+	constexpr size_t RING_CAPACITY = 64; // Small, so producers keep running into a full ring
+
+	// A full ring refuses pushes until the consumer frees a cell, and keeps FIFO order
+	void fullRing()
+	{
+		CallQueue<int, 8> queue;
+		for (int i = 0; i < 8; i++)
+		{
+			check(queue.push(i), "push into a ring with free cells succeeds");
+		}
+		check(!queue.push(8), "push into a full ring returns false");
+
+		int value = -1;
+		check(queue.pop(value) && value == 0, "pop returns the oldest element");
+		check(queue.push(8), "push succeeds again once a cell is freed");
+		check(!queue.push(9), "push fails again when the ring is full");
+
+		int expected = 1;
+		size_t drained = queue.drain([&](int v)
+			{
+				check(v == expected, "drain keeps FIFO order");
+				++expected;
+			});
+		check(drained == 8, "drain returns every queued element");
+		check(!queue.pop(value), "pop on an empty ring returns false");
+	}
+
+	// Producers push concurrently while the consumer drains: every element arrives exactly
+	// once, and the elements of one producer in the order it pushed them
+	void concurrentProducers()
+	{
+		CallQueue<uint64_t, RING_CAPACITY> queue;
+		std::atomic<bool> start{ false };
+		std::atomic<uint64_t> refused{ 0 };
+		std::vector<std::thread> producers;
+		for (int producer = 0; producer < PRODUCERS; producer++)
+		{
+			producers.emplace_back([&, producer]
+				{
+					while (!start.load(std::memory_order_acquire))
+					{
+						std::this_thread::yield();
+					}
+					for (uint32_t i = 0; i < PUSHES_PER_PRODUCER; i++)
+					{
+						uint64_t value = (static_cast<uint64_t>(producer) << 32) | i;
+						while (!queue.push(value))
+						{
+							refused.fetch_add(1, std::memory_order_relaxed);
+							std::this_thread::yield();
+						}
+					}
+				});
+		}
+
+		std::vector<std::vector<uint8_t>> seen(PRODUCERS, std::vector<uint8_t>(PUSHES_PER_PRODUCER, 0));
+		std::vector<int64_t> last(PRODUCERS, -1);
+		uint64_t total = 0;
+		bool valid = true;
+		bool ordered = true;
+		start.store(true, std::memory_order_release);
+		while (total < static_cast<uint64_t>(PRODUCERS) * PUSHES_PER_PRODUCER && valid)
+		{
+			size_t drained = queue.drain([&](uint64_t value)
+				{
+					uint64_t producer = value >> 32;
+					uint32_t index = static_cast<uint32_t>(value);
+					if (producer >= PRODUCERS || index >= PUSHES_PER_PRODUCER)
+					{
+						valid = false;
+						return;
+					}
+					++seen[producer][index];
+					ordered = ordered && static_cast<int64_t>(index) > last[producer];
+					last[producer] = index;
+				});
+			total += drained;
+			if (drained == 0)
+			{
+				std::this_thread::yield();
+			}
+		}
+		for (auto& t : producers)
+		{
+			t.join();
+		}
+
+		check(valid, "every drained element was pushed by a producer");
+		bool once = true;
+		for (const auto& counts : seen)
+		{
+			for (uint8_t count : counts)
+			{
+				once = once && count == 1;
+			}
+		}
+		check(once, "every pushed element is drained exactly once");
+		check(ordered, "elements of one producer are drained in push order");
+		uint64_t extra = 0;
+		check(!queue.pop(extra), "nothing is left after the last element");
+		std::printf("%llu elements, %llu pushes refused by a full ring\n",
+			static_cast<unsigned long long>(total), static_cast<unsigned long long>(refused.load()));
+	}
+}
+
+int main()
+{
+	fullRing();
+	concurrentProducers();
+	return testFailures;
+}
@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "DemandModel.h"
+#include "TestCheck.h"
+
+namespace
+{
+	constexpr int FLOORS = 30;
+	constexpr double SLOT_START = 8.0 * 3600.0; // A slot of the morning, on day 0
+
+	// The ranked origins are those a full sort of the counts gives
+	void rankingMatchesSort()
+	{
+		DemandModel model(FLOORS);
+		std::vector<int> counts(FLOORS, 0);
+		std::mt19937 random(7);
+		std::geometric_distribution<int> floor(0.15);
+		for (int i = 0; i < 5000; i++)
+		{
+			int origin = std::min(floor(random), FLOORS - 1);
+			model.observe(SLOT_START + i * 0.1, origin, (origin + 1) % FLOORS);
+			++counts[origin];
+		}
+
+		std::vector<int> expected;
+		for (int f = 0; f < FLOORS; f++)
+		{
+			if (counts[f] > 0)
+			{
+				expected.push_back(f);
+			}
+		}
+		std::stable_sort(expected.begin(), expected.end(), [&](int a, int b) { return counts[a] > counts[b]; });
+		expected.resize(std::min<size_t>(expected.size(), DEMAND_TOP_ORIGINS));
+
+		std::vector<int> ranked;
+		model.busiestOrigins(SLOT_START, FLOORS, ranked);
+		check(ranked == expected, "busiestOrigins returns the busiest floors, busiest first");
+		model.busiestOrigins(SLOT_START, 3, ranked);
+		check(ranked.size() == 3 && std::equal(ranked.begin(), ranked.end(), expected.begin()), "busiestOrigins stops at count");
+		check(model.busiestOrigin(SLOT_START, -1) == expected[0], "busiestOrigin is the first ranked floor");
+	}
+
+	// A slot whose calls stop fades out within days, both in rates and as a parking target
+	void staleSlotFades()
+	{
+		DemandModel model(FLOORS);
+		for (int i = 0; i < 20; i++)
+		{
+			model.observe(SLOT_START + i, 5, 0);
+		}
+		double fresh = model.originRate(SLOT_START + DEMAND_DAY, 5);
+		check(fresh > 0.0, "the next day expects the calls of the day before");
+		check(model.busiestOrigin(SLOT_START + DEMAND_DAY, -1) == 5, "the busy floor is the parking target the next day");
+
+		double later = model.originRate(SLOT_START + 5 * DEMAND_DAY, 5);
+		check(later < fresh * 0.5, "days without calls lower the expected rate");
+		check(model.busiestOrigin(SLOT_START + 30 * DEMAND_DAY, -1) == -1, "a slot quiet for a month has no busiest floor");
+		std::vector<int> ranked;
+		model.busiestOrigins(SLOT_START + 30 * DEMAND_DAY, 4, ranked);
+		check(ranked.empty(), "a slot quiet for a month has no busy floors");
+		std::printf("rate %.1f/h the next day, %.1f/h after four quiet days\n", fresh, later);
+	}
+}
+
+int main()
+{
+	rankingMatchesSort();
+	staleSlotFades();
+	return testFailures;
+}
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+#include <vector>
+#include "JourneyLog.h"
+#include "TestCheck.h"
+
+namespace
+{
+	constexpr int WRITERS = 3;
+	constexpr uint64_t RECORDS_PER_WRITER = 2 * JOURNEY_CHUNK_ROWS + 123; // Full chunks and a partial one
+
+	// Record number i of a writer; times in whole milliseconds, as the log stores them
+	journeyRecord makeRecord(int writer, uint64_t i)
+	{
+		double arrival = static_cast<double>(i * 1237 % 86400000) / 1000.0;
+		double board = arrival + static_cast<double>(i % 90001) / 1000.0;
+		double alight = board + static_cast<double>(i % 4001 + 1) / 1000.0;
+		int16_t floor = static_cast<int16_t>(i % 40);
+		return { static_cast<uint64_t>(writer) * 1000000000000ull + i * 7, static_cast<uint32_t>(writer * 1000 + i % 13),
+			static_cast<int16_t>(i % 4), floor, static_cast<int16_t>((floor + 1 + i % 39) % 40), arrival, board, alight };
+	}
+
+	bool sameRecord(const journeyRecord& a, const journeyRecord& b)
+	{
+		auto sameTime = [](double x, double y) { return std::llround(x * 1000.0) == std::llround(y * 1000.0); };
+		return a.passengerId == b.passengerId && a.building == b.building && a.car == b.car
+			&& a.startFloor == b.startFloor && a.destination == b.destination
+			&& sameTime(a.arrivalTime, b.arrivalTime) && sameTime(a.boardTime, b.boardTime) && sameTime(a.alightTime, b.alightTime);
+	}
+
+	bool byId(const journeyRecord& a, const journeyRecord& b)
+	{
+		return a.passengerId < b.passengerId;
+	}
+}
+
+int main()
+{
+	std::string path = (std::filesystem::temp_directory_path() / "SymulatorWindyJourneyLogTest.swjl").string();
+	{
+		JourneyLog log(path);
+		check(log.isOpen(), "the log file can be created");
+		std::vector<std::thread> writers;
+		for (int w = 0; w < WRITERS; w++)
+		{
+			writers.emplace_back([&log, w]
+				{
+					for (uint64_t i = 0; i < RECORDS_PER_WRITER; i++)
+					{
+						log.append(makeRecord(w, i));
+					}
+				});
+		}
+		for (auto& t : writers)
+		{
+			t.join();
+		}
+		check(log.close(), "the log is closed without errors");
+		check(log.recordsWritten() == WRITERS * RECORDS_PER_WRITER, "every appended record is written");
+	}
+
+	std::vector<journeyRecord> expected;
+	for (int w = 0; w < WRITERS; w++)
+	{
+		for (uint64_t i = 0; i < RECORDS_PER_WRITER; i++)
+		{
+			expected.push_back(makeRecord(w, i));
+		}
+	}
+
+	JourneyLogReader reader(path);
+	check(reader.isOpen(), "the written log can be opened");
+	check(reader.recordCount() == expected.size(), "the footer counts every record");
+	std::vector<journeyRecord> actual;
+	std::vector<journeyRecord> chunk;
+	for (size_t i = 0; i < reader.chunkCount(); i++)
+	{
+		check(reader.readChunk(i, chunk), "every chunk decodes");
+		actual.insert(actual.end(), chunk.begin(), chunk.end());
+	}
+	check(!reader.readChunk(reader.chunkCount(), chunk), "reading past the last chunk fails");
+
+	// Chunks of different threads interleave in the file, so compare in passenger order
+	std::sort(expected.begin(), expected.end(), byId);
+	std::sort(actual.begin(), actual.end(), byId);
+	check(actual.size() == expected.size(), "as many records are read as were written");
+	bool same = actual.size() == expected.size();
+	for (size_t i = 0; same && i < actual.size(); i++)
+	{
+		same = sameRecord(actual[i], expected[i]);
+	}
+	check(same, "every record reads back as written");
+
+	// A log whose writing was cut short has no footer and is rejected
+	std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+	JourneyLogReader truncated(path);
+	check(!truncated.isOpen(), "a truncated log is rejected");
+
+	std::filesystem::remove(path);
+	std::printf("%zu records in %zu chunks read back\n", actual.size(), reader.chunkCount());
+	return testFailures;
+}
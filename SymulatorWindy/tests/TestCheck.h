@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdio>
+
+// Minimal checks for the test programs run by ctest. A failed check is reported and
+// counted; the program returns the count, so any failure fails the test.
+
+inline int testFailures = 0;
+
+inline void check(bool ok, const char* what)
+{
+	if (!ok)
+	{
+		std::fprintf(stderr, "FAIL: %s\n", what);
+		++testFailures;
+	}
+}
@@ -0,0 +1,106 @@
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "FrameSnapshot.h"
+#include "TestCheck.h"
+
+namespace
+{
+	constexpr uint64_t FRAMES = 300000;
+
+	// Every field of frame `sequence` is derived from the sequence number, so a frame
+	// mixing two publications (torn) is detected
+	size_t spriteCount(uint64_t sequence)
+	{
+		return static_cast<size_t>(sequence % 17) + 1;
+	}
+
+	void writeFrame(frameSnapshot& frame, uint64_t sequence)
+	{
+		frame.sequence = sequence;
+		frame.sprites.resize(spriteCount(sequence));
+		for (size_t i = 0; i < frame.sprites.size(); i++)
+		{
+			frame.sprites[i] = { static_cast<size_t>(sequence), L"", static_cast<int>(i), static_cast<int>(sequence), 0, 0 };
+		}
+		frame.lines.assign(sequence % 3, { 0, 0, 0, 0, static_cast<uint32_t>(sequence), 1.0f });
+		frame.texts.assign(1, { std::to_wstring(sequence), 0, 0, L"", 16.0f, 0 });
+	}
+
+	bool frameIntact(const frameSnapshot& frame)
+	{
+		uint64_t sequence = frame.sequence;
+		if (frame.sprites.size() != spriteCount(sequence) || frame.lines.size() != sequence % 3
+			|| frame.texts.size() != 1 || frame.texts[0].text != std::to_wstring(sequence))
+		{
+			return false;
+		}
+		for (size_t i = 0; i < frame.sprites.size(); i++)
+		{
+			const frameSprite& s = frame.sprites[i];
+			if (s.spriteId != sequence || s.x != static_cast<int>(i) || s.y != static_cast<int>(sequence))
+			{
+				return false;
+			}
+		}
+		for (const auto& line : frame.lines)
+		{
+			if (line.argb != static_cast<uint32_t>(sequence))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main()
+{
+	TripleBuffer<frameSnapshot> buffer;
+	std::atomic<bool> start{ false };
+	std::thread producer([&]
+		{
+			while (!start.load(std::memory_order_acquire))
+			{
+				std::this_thread::yield();
+			}
+			for (uint64_t sequence = 1; sequence <= FRAMES; sequence++)
+			{
+				writeFrame(buffer.writeBuffer(), sequence);
+				buffer.publish();
+				if (sequence % 64 == 0)
+				{
+					std::this_thread::yield(); // Let the consumer run on machines with one core
+				}
+			}
+		});
+
+	uint64_t last = 0;
+	uint64_t acquired = 0;
+	bool increasing = true;
+	bool intact = true;
+	start.store(true, std::memory_order_release);
+	while (last < FRAMES)
+	{
+		const frameSnapshot* frame = buffer.acquire();
+		if (frame == nullptr)
+		{
+			check(buffer.readBuffer().sequence == last, "the read buffer stays put between publications");
+			std::this_thread::yield();
+			continue;
+		}
+		++acquired;
+		increasing = increasing && frame->sequence > last;
+		intact = intact && frameIntact(*frame);
+		last = frame->sequence;
+	}
+	producer.join();
+
+	check(increasing, "acquired frames have strictly increasing sequence numbers");
+	check(intact, "no acquired frame is torn");
+	check(last == FRAMES, "the last published frame is acquired");
+	check(buffer.acquire() == nullptr, "nothing is fresh after the last frame");
+	std::printf("%llu of %llu frames acquired\n",
+		static_cast<unsigned long long>(acquired), static_cast<unsigned long long>(FRAMES));
+	return testFailures;
+}